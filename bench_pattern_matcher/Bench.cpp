@@ -0,0 +1,169 @@
+#include "bench_pattern_matcher/Bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BENCH_RUSAGE 1
+#include <sys/resource.h>
+#else
+#define BENCH_RUSAGE 0
+#endif
+
+namespace
+{
+    std::atomic<size_t> ourAllocations = 0;
+
+    std::string Escaped(const std::string& aText)
+    {
+        std::string out;
+        for (char c : aText)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out;
+    }
+}  // namespace
+
+void* operator new(size_t aSize)
+{
+    ourAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* out = std::malloc(aSize ? aSize : 1))
+        return out;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t aSize) { return operator new(aSize); }
+
+void operator delete(void* aPointer) noexcept { std::free(aPointer); }
+void operator delete[](void* aPointer) noexcept { std::free(aPointer); }
+void operator delete(void* aPointer, size_t) noexcept { std::free(aPointer); }
+void operator delete[](void* aPointer, size_t) noexcept { std::free(aPointer); }
+
+namespace bench
+{
+    size_t Allocations() { return ourAllocations.load(std::memory_order_relaxed); }
+
+    size_t PeakRss()
+    {
+#if BENCH_RUSAGE
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+
+#if defined(__APPLE__)
+        return static_cast<size_t>(usage.ru_maxrss);
+#else
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    double BenchResult::MegabytesPerSecond() const
+    {
+        if (myBytes == 0 || mySeconds == 0)
+            return 0;
+
+        return static_cast<double>(myBytes) * static_cast<double>(myIterations) / mySeconds / 1'000'000.0;
+    }
+
+    double BenchResult::StepsPerByte() const
+    {
+        if (myBytes == 0)
+            return 0;
+
+        return static_cast<double>(mySteps) / static_cast<double>(myBytes);
+    }
+
+    double BenchResult::AllocationsPerIteration() const
+    {
+        if (myIterations == 0)
+            return 0;
+
+        return static_cast<double>(myAllocations) / static_cast<double>(myIterations);
+    }
+
+    void BenchRunner::PrintHeader(FILE* aLog)
+    {
+        fprintf(aLog, "%-32s %10s %12s %12s %10s %12s %10s\n", "benchmark", "iterations", "ms/iter", "MB/s",
+                "steps/B", "allocs/iter", "peak MB");
+    }
+
+    void BenchRunner::Run(const Benchmark& aBenchmark, FILE* aLog)
+    {
+        if (aBenchmark.myName.find(myOptions.myFilter) == std::string::npos)
+            return;
+
+        using Clock = std::chrono::steady_clock;
+
+        BenchResult result;
+        result.myName        = aBenchmark.myName;
+        result.myBytes       = aBenchmark.myBytes;
+        result.myBestSeconds = std::numeric_limits<double>::max();
+
+        if (aBenchmark.mySteps)
+            result.mySteps = aBenchmark.mySteps();
+
+        while (result.mySeconds < myOptions.myMinSeconds || result.myIterations < myOptions.myMinIterations)
+        {
+            if (aBenchmark.mySetup)
+                aBenchmark.mySetup();
+
+            size_t allocations      = Allocations();
+            Clock::time_point start = Clock::now();
+
+            aBenchmark.myWork();
+
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+            result.myAllocations += Allocations() - allocations;
+            result.mySeconds += seconds;
+            result.myIterations++;
+
+            result.myBestSeconds = std::min(result.myBestSeconds, seconds);
+        }
+
+        result.myPeakRss = PeakRss();
+
+        fprintf(aLog, "%-32.32s %10zu %12.3f %12.1f %10.2f %12.1f %10.1f\n", result.myName.c_str(),
+                result.myIterations, result.mySeconds * 1'000.0 / static_cast<double>(result.myIterations),
+                result.MegabytesPerSecond(), result.StepsPerByte(), result.AllocationsPerIteration(),
+                static_cast<double>(result.myPeakRss) / 1'000'000.0);
+        fflush(aLog);
+
+        myResults.push_back(std::move(result));
+    }
+
+    std::string BenchRunner::Json() const
+    {
+        std::string out = "{\n  \"benchmarks\": [";
+
+        char line[512];
+        for (size_t i = 0; i < myResults.size(); i++)
+        {
+            const BenchResult& result = myResults[i];
+
+            snprintf(line, sizeof(line),
+                     "%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"seconds\": %.9f, \"best_seconds\": %.9f, "
+                     "\"bytes\": %zu, \"mb_per_second\": %.3f, \"steps\": %zu, \"steps_per_byte\": %.4f, "
+                     "\"allocations_per_iteration\": %.2f, \"peak_rss_bytes\": %zu}",
+                     i == 0 ? "" : ",", Escaped(result.myName).c_str(), result.myIterations, result.mySeconds,
+                     result.myBestSeconds, result.myBytes, result.MegabytesPerSecond(), result.mySteps,
+                     result.StepsPerByte(), result.AllocationsPerIteration(), result.myPeakRss);
+            out += line;
+        }
+
+        out += "\n  ]\n}\n";
+        return out;
+    }
+}  // namespace bench
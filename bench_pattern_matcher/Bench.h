@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    struct Benchmark
+    {
+        std::string myName;
+
+        // Input handled by one run of myWork, 0 when throughput makes no sense for it
+        size_t myBytes = 0;
+
+        // Run before every run of myWork, neither timed nor counted
+        std::function<void()> mySetup;
+        std::function<void()> myWork;
+
+        // Steps one run of myWork takes, run once outside the timing. Empty when the work is not a match.
+        std::function<size_t()> mySteps;
+    };
+
+    struct BenchResult
+    {
+        std::string myName;
+        size_t myIterations  = 0;
+        double mySeconds     = 0;
+        double myBestSeconds = 0;
+        size_t myBytes       = 0;
+        size_t mySteps       = 0;
+        size_t myAllocations = 0;
+        // Of the whole process when the benchmark was done, in bytes
+        size_t myPeakRss = 0;
+
+        double MegabytesPerSecond() const;
+        double StepsPerByte() const;
+        double AllocationsPerIteration() const;
+    };
+
+    struct BenchOptions
+    {
+        // Each benchmark runs until it has been timed for this long, and at least myMinIterations times
+        double myMinSeconds    = 0.5;
+        size_t myMinIterations = 3;
+
+        // Only benchmarks with this in their name run
+        std::string myFilter;
+    };
+
+    class BenchRunner
+    {
+    public:
+        explicit BenchRunner(const BenchOptions& aOptions) : myOptions(aOptions) {}
+
+        // Runs aBenchmark unless filtered out and prints a line about it to aLog
+        void Run(const Benchmark& aBenchmark, FILE* aLog = stdout);
+
+        const std::vector<BenchResult>& Results() const { return myResults; }
+
+        static void PrintHeader(FILE* aLog = stdout);
+
+        // The results as one JSON object, for comparing runs between releases
+        std::string Json() const;
+
+    private:
+        BenchOptions myOptions;
+        std::vector<BenchResult> myResults;
+    };
+
+    // Heap allocations made by this process so far
+    size_t Allocations();
+
+    // Largest resident set size this process has had, in bytes. 0 where the platform does not say.
+    size_t PeakRss();
+}  // namespace bench
@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench_pattern_matcher/Bench.h"
+#include "catch_pattern_matcher/JSON.h"
+#include "pattern_matcher/Generator.h"
+#include "pattern_matcher/PatternBuilder.h"
+#include "pattern_matcher/Profile.h"
+
+#ifndef BENCH_JSON_TEST_CASES_PATH
+#define BENCH_JSON_TEST_CASES_PATH ""
+#endif
+
+namespace
+{
+    void PrintUsage()
+    {
+        fputs("usage: pattern_matcher_bench [options]\n"
+              "  --filter TEXT      only run benchmarks with TEXT in their name\n"
+              "  --min-time SECONDS time each benchmark for at least this long, default 0.5\n"
+              "  --scale N          make the synthetic inputs N times larger, default 1\n"
+              "  --corpus DIR       JSONTestSuite test_parsing directory\n"
+              "  --json PATH        also write the results as JSON to PATH, - for stdout\n",
+              stderr);
+    }
+
+    // An array of numbers in all the shapes JSON allows
+    std::string MakeNumbers(size_t aBytes)
+    {
+        std::string out = "[";
+
+        for (size_t i = 0; out.size() < aBytes; i++)
+        {
+            if (i != 0)
+                out += ", ";
+
+            switch (i % 4)
+            {
+                case 0:
+                    out += std::to_string(i * 7919 % 1'000'003);
+                    break;
+                case 1:
+                    out += "-" + std::to_string(i % 977) + "." + std::to_string(i * 31 % 10'000);
+                    break;
+                case 2:
+                    out += std::to_string(i % 89) + ".5e-" + std::to_string(i % 17);
+                    break;
+                case 3:
+                    out += "0";
+                    break;
+            }
+        }
+
+        return out + "]";
+    }
+
+    // Records of nested objects, the shape of most JSON in the wild
+    std::string MakeRecords(size_t aBytes)
+    {
+        std::string out = "[\n";
+
+        for (size_t i = 0; out.size() < aBytes; i++)
+        {
+            if (i != 0)
+                out += ",\n";
+
+            out += "  {\"id\": " + std::to_string(i) + ", \"name\": \"record " + std::to_string(i)
+                 + "\", \"active\": " + (i % 3 ? "true" : "false") + ", \"parent\": null,\n"
+                 + "   \"tags\": [\"a\", \"b\\n\", \"\\u00e9\"], \"position\": {\"x\": " + std::to_string(i % 640)
+                 + ".25, \"y\": -" + std::to_string(i % 480) + ".5}}";
+        }
+
+        return out + "\n]";
+    }
+
+    // Long strings full of escapes
+    std::string MakeStrings(size_t aBytes)
+    {
+        std::string out = "[";
+
+        for (size_t i = 0; out.size() < aBytes; i++)
+        {
+            if (i != 0)
+                out += ",";
+
+            out += "\"";
+            for (size_t j = 0; j < 64; j++) out += j % 9 == 0 ? "\\\"" : j % 13 == 0 ? "\\u12aB" : "x";
+            out += "\"";
+        }
+
+        return out + "]";
+    }
+
+    // A grammar of aRules rules that refer to each other, written as FromBNF reads it
+    std::string MakeGrammar(size_t aRules)
+    {
+        std::string out;
+
+        for (size_t i = 0; i < aRules; i++)
+        {
+            std::string name = "rule-" + std::to_string(i);
+            std::string next = "rule-" + std::to_string((i + 1) % aRules);
+
+            out += name + ":\n";
+            out += "        \"k" + std::to_string(i) + "\" [a-z_]* " + next + "?\n";
+            out += "        [0-9]+ \"" + std::to_string(i) + "\"\n";
+            out += "        \"(\" " + name + "-items* \")\"\n";
+            out += "\n";
+
+            out += name + "-items:\n";
+            out += "        [^()\\n]+ \",\"? " + next + "\n";
+            out += "\n";
+        }
+
+        return out;
+    }
+
+    std::vector<std::string> LoadCorpus(const std::filesystem::path& aRoot)
+    {
+        std::vector<std::string> out;
+
+        std::error_code error;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(aRoot, error))
+        {
+            std::ifstream file(entry.path(), std::ios::binary);
+            out.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        return out;
+    }
+
+    size_t TotalSize(const std::vector<std::string>& aTexts)
+    {
+        size_t out = 0;
+        for (const std::string& text : aTexts) out += text.size();
+        return out;
+    }
+}  // namespace
+
+int main(int aArgc, char** aArgv)
+{
+    using namespace pattern_matcher;
+
+    bench::BenchOptions options;
+    size_t scale                     = 1;
+    std::filesystem::path corpusPath = BENCH_JSON_TEST_CASES_PATH;
+    std::string jsonPath;
+
+    for (int i = 1; i < aArgc; i++)
+    {
+        std::string_view arg = aArgv[i];
+
+        if (arg == "--help" || i + 1 == aArgc)
+        {
+            PrintUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+
+        const char* value = aArgv[++i];
+
+        if (arg == "--filter")
+            options.myFilter = value;
+        else if (arg == "--min-time")
+            options.myMinSeconds = std::strtod(value, nullptr);
+        else if (arg == "--scale")
+            scale = std::max<size_t>(std::strtoull(value, nullptr, 10), 1);
+        else if (arg == "--corpus")
+            corpusPath = value;
+        else if (arg == "--json")
+            jsonPath = value;
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    // Progress goes to stderr when the JSON goes to stdout
+    FILE* log = jsonPath == "-" ? stderr : stdout;
+
+    bench::BenchRunner runner(options);
+    bench::BenchRunner::PrintHeader(log);
+
+    PatternMatcher json = MakeJsonParser().Finalize();
+
+    // Adds a benchmark of matching or recognizing aTexts, one after the other
+    auto addJson = [&](std::string aName, const std::vector<std::string>& aTexts, bool aTree) {
+        bench::Benchmark benchmark;
+        benchmark.myName  = std::move(aName);
+        benchmark.myBytes = TotalSize(aTexts);
+
+        if (aTree)
+            benchmark.myWork = [&]() {
+                for (const std::string& text : aTexts) json.Match("value", text);
+            };
+        else
+            benchmark.myWork = [&]() {
+                for (const std::string& text : aTexts) json.Recognize("value", text);
+            };
+
+        benchmark.mySteps = [&]() {
+            StepCounter counter;
+            for (const std::string& text : aTexts) json.Recognize("value", text, counter);
+            return counter.mySteps;
+        };
+
+        runner.Run(benchmark, log);
+    };
+
+    std::vector<std::string> corpus = LoadCorpus(corpusPath);
+    if (corpus.empty())
+        fprintf(stderr, "no JSONTestSuite corpus at '%s', skipping json::corpus\n", corpusPath.string().c_str());
+    else
+        addJson("json::corpus", corpus, true);
+
+    size_t bytes = scale << 20;
+
+    std::vector<std::string> numbers{MakeNumbers(bytes)};
+    std::vector<std::string> records{MakeRecords(bytes)};
+    std::vector<std::string> strings{MakeStrings(bytes)};
+
+    addJson("json::numbers", numbers, true);
+    addJson("json::records", records, true);
+    addJson("json::records_recognize", records, false);
+    addJson("json::strings", strings, true);
+
+    InputGenerator generator(json["value"]);
+
+    std::vector<std::string> generated(1);
+    generator.Generate(generated[0], bytes, json["array-continuations"]);
+
+    addJson("json::generated", generated, true);
+
+    // The same json inputs through the bytecode VM, to compare with the interpreter above
+    Program program = json.Compile("value");
+
+    auto addProgram = [&](std::string aName, const std::vector<std::string>& aTexts) {
+        bench::Benchmark benchmark;
+        benchmark.myName  = std::move(aName);
+        benchmark.myBytes = TotalSize(aTexts);
+        benchmark.myWork  = [&]() {
+            for (const std::string& text : aTexts) program.Match(text.begin(), text.end());
+        };
+
+        runner.Run(benchmark, log);
+    };
+
+    addProgram("program::numbers", numbers);
+    addProgram("program::records", records);
+    addProgram("program::strings", strings);
+
+    {
+        std::string out;
+
+        bench::Benchmark benchmark;
+        benchmark.myName  = "generator::json";
+        benchmark.myBytes = bytes;
+        benchmark.mySetup = [&]() { out.clear(); };
+        benchmark.myWork  = [&]() { generator.GenerateRecords(out, bytes); };
+
+        runner.Run(benchmark, log);
+    }
+
+    {
+        std::optional<PatternBuilder> builder;
+
+        bench::Benchmark benchmark;
+        benchmark.myName  = "finalize::json";
+        benchmark.mySetup = [&]() { builder = MakeJsonParser(); };
+        benchmark.myWork  = [&]() { builder->Finalize(); };
+
+        runner.Run(benchmark, log);
+    }
+
+    std::string grammar    = MakeGrammar(scale * 500);
+    PatternMatcher bnfMeta = PatternBuilder::Builtin::BNF();
+
+    {
+        bench::Benchmark benchmark;
+        benchmark.myName  = "bnf::meta_parser";
+        benchmark.myBytes = grammar.size();
+        benchmark.myWork  = [&]() { bnfMeta.Match("doc", grammar); };
+        benchmark.mySteps = [&]() {
+            StepCounter counter;
+            bnfMeta.Recognize("doc", grammar, counter);
+            return counter.mySteps;
+        };
+
+        runner.Run(benchmark, log);
+    }
+
+    {
+        bench::Benchmark benchmark;
+        benchmark.myName  = "bnf::from_bnf";
+        benchmark.myBytes = grammar.size();
+        benchmark.myWork  = [&]() { PatternBuilder::FromBNF(grammar); };
+
+        runner.Run(benchmark, log);
+    }
+
+    if (jsonPath == "-")
+    {
+        fputs(runner.Json().c_str(), stdout);
+    }
+    else if (!jsonPath.empty())
+    {
+        std::ofstream out(jsonPath, std::ios::binary);
+        out << runner.Json();
+
+        if (!out)
+        {
+            fprintf(stderr, "could not write '%s'\n", jsonPath.c_str());
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+#include <atomic>
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    std::atomic<bool> ourCounting      = false;
+    std::atomic<size_t> ourAllocations = 0;
+
+    // Counts the heap allocations made while alive
+    class AllocationCounter
+    {
+    public:
+        AllocationCounter()
+        {
+            ourAllocations = 0;
+            ourCounting    = true;
+        }
+
+        ~AllocationCounter() { ourCounting = false; }
+
+        size_t Count() const { return ourAllocations; }
+    };
+
+    std::string MakeArray(size_t aItems)
+    {
+        std::string out = "[";
+
+        for (size_t i = 0; i < aItems; i++)
+        {
+            if (i != 0)
+                out += ", ";
+            out += std::to_string(i * 7919 % 100'000);
+        }
+
+        return out + "]";
+    }
+
+    size_t CountNodes(const pattern_matcher::Success<std::string::iterator>& aSuccess)
+    {
+        size_t count = 1;
+        for (const pattern_matcher::Success<std::string::iterator>& child : aSuccess.mySubMatches)
+            count += CountNodes(child);
+        return count;
+    }
+}  // namespace
+
+void* operator new(size_t aSize)
+{
+    if (ourCounting)
+        ourAllocations++;
+
+    if (void* out = std::malloc(aSize ? aSize : 1))
+        return out;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t aSize) { return operator new(aSize); }
+
+void operator delete(void* aPointer) noexcept { std::free(aPointer); }
+void operator delete[](void* aPointer) noexcept { std::free(aPointer); }
+void operator delete(void* aPointer, size_t) noexcept { std::free(aPointer); }
+void operator delete[](void* aPointer, size_t) noexcept { std::free(aPointer); }
+
+TEST_CASE("allocations::flat_tree", "[allocations]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string small = MakeArray(16);
+    std::string large = MakeArray(4'096);
+
+    ParseTree<std::string::iterator> tree;
+
+    // Grow the tree once, after which it fits every following match
+    REQUIRE(matcher.Match("value", large, tree));
+
+    size_t smallAllocations;
+    {
+        AllocationCounter counter;
+        REQUIRE(matcher.Match("value", small, tree));
+        smallAllocations = counter.Count();
+    }
+
+    size_t largeAllocations;
+    {
+        AllocationCounter counter;
+        REQUIRE(matcher.Match("value", large, tree));
+        largeAllocations = counter.Count();
+    }
+
+    // Only the per match setup allocates, stepping through the input does not
+    REQUIRE(largeAllocations == smallAllocations);
+    REQUIRE(largeAllocations <= 1);
+}
+
+TEST_CASE("allocations::success_tree", "[allocations]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["a"] = "a";
+    builder["b"] = "b";
+    builder["letter"] || "a" || "b";
+
+    // Every "a" is first tried as each of the longer words, which fail without leaving a node behind. A "b" is not
+    // tried as them at all, so both inputs give the same tree from a different number of steps.
+    builder["ax"] = "ax";
+    builder["ay"] = "ay";
+    builder["az"] = "az";
+    builder["item"] || "ax" || "ay" || "az" || "letter";
+    builder["items"] = {"item", {1, RepeatCount::Unbounded}};
+
+    PatternMatcher matcher = builder.Finalize();
+
+    std::string few  = std::string(1'024, 'b');
+    std::string many = std::string(1'024, 'a');
+
+    StepCounter fewSteps;
+    StepCounter manySteps;
+    REQUIRE(matcher.Recognize("items", few, fewSteps) == few.end());
+    REQUIRE(matcher.Recognize("items", many, manySteps) == many.end());
+    REQUIRE(manySteps.mySteps > fewSteps.mySteps * 3 / 2);
+
+    std::optional<Success<std::string::iterator>> fewResult;
+    size_t fewAllocations;
+    {
+        AllocationCounter counter;
+        fewResult      = matcher.Match("items", few);
+        fewAllocations = counter.Count();
+    }
+
+    std::optional<Success<std::string::iterator>> manyResult;
+    size_t manyAllocations;
+    {
+        AllocationCounter counter;
+        manyResult      = matcher.Match("items", many);
+        manyAllocations = counter.Count();
+    }
+
+    REQUIRE(fewResult);
+    REQUIRE(manyResult);
+    REQUIRE(CountNodes(*fewResult) == CountNodes(*manyResult));
+
+    // Sub matches are moved up the tree, so allocations follow the nodes built and not the steps taken
+    REQUIRE(manyAllocations == fewAllocations);
+    REQUIRE(manyAllocations <= CountNodes(*manyResult));
+}
+
+TEST_CASE("allocations::recognize", "[allocations]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = MakeArray(4'096);
+
+    std::optional<std::string::iterator> end;
+    size_t allocations;
+    {
+        AllocationCounter counter;
+        end         = matcher.Recognize("value", input);
+        allocations = counter.Count();
+    }
+
+    REQUIRE(end == input.end());
+
+    // The context stack is the only allocation
+    REQUIRE(allocations <= 1);
+}
+
+TEST_CASE("allocations::too_short", "[allocations]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input    = "\\u12";
+    const Fragment* root = matcher["string-unicode-escape"];
+
+    std::optional<std::string::iterator> end;
+    size_t allocations;
+    {
+        AllocationCounter counter;
+        end         = matcher.Recognize(root, input);
+        allocations = counter.Count();
+    }
+
+    // Shorter than any match, rejected before the context stack is set up
+    REQUIRE(!end);
+    REQUIRE(allocations == 0);
+}
+
+TEST_CASE("allocations::leaf_fragments", "[allocations]")
+{
+    using namespace pattern_matcher;
+
+    size_t allocations;
+    {
+        AllocationCounter counter;
+
+        Fragment literal('a');
+        Fragment none;
+        Fragment copy = literal;
+
+        REQUIRE(copy.First().Contains('a'));
+        REQUIRE(!copy.First().Contains('b'));
+        REQUIRE(!none.First().Contains('a'));
+
+        allocations = counter.Count();
+    }
+
+    // Only fragments with variable sized parts have a storage of their own
+    REQUIRE(allocations == 0);
+}
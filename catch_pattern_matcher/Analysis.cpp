@@ -0,0 +1,170 @@
+#include <catch2/catch_all.hpp>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "catch_pattern_matcher/TreeEquality.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+TEST_CASE("analysis::first", "[analysis]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["a"] = "a";
+    builder["b"] = "b";
+    builder["c"] = "c";
+    builder["a-optional"] = {"a", {0, 1}};
+    builder["prefix"] && "a-optional" && "b";
+    builder["choice"] || "prefix" || "c" || "a-optional";
+
+    PatternMatcher matcher = builder.Finalize();
+
+    REQUIRE(matcher["a-optional"]->IsNullable());
+    REQUIRE(matcher["a-optional"]->First() == CharClass::Of("a"));
+
+    REQUIRE(!matcher["prefix"]->IsNullable());
+    REQUIRE(matcher["prefix"]->First() == CharClass::Of("ab"));
+
+    const Fragment* choice = matcher["choice"];
+    REQUIRE(choice->IsNullable());
+    REQUIRE(choice->First() == CharClass::Of("abc"));
+
+    REQUIRE(choice->IsCandidate(0, 'b'));
+    REQUIRE(!choice->IsCandidate(1, 'b'));
+    REQUIRE(choice->IsCandidate(2, 'b'));
+    REQUIRE(!choice->IsCandidate(0, 'c'));
+    REQUIRE(choice->IsCandidate(1, 'c'));
+    REQUIRE(!choice->IsCandidate(0, std::nullopt));
+    REQUIRE(!choice->IsCandidate(1, std::nullopt));
+    REQUIRE(choice->IsCandidate(2, std::nullopt));
+}
+
+TEST_CASE("analysis::candidate_widths", "[analysis]")
+{
+    using namespace pattern_matcher;
+
+    // Rows of 1, 2, 4 and 8 bytes
+    size_t branches = GENERATE(3, 12, 20, 40, 64);
+
+    PatternBuilder builder;
+
+    for (size_t i = 0; i < branches; i++)
+    {
+        std::string name = "branch-" + std::to_string(i);
+        builder[name]    = std::string{static_cast<char>('0' + i), '!'};
+        builder["choice"] || name;
+    }
+
+    PatternMatcher matcher = builder.Finalize();
+
+    const Fragment* choice = matcher["choice"];
+
+    for (size_t i = 0; i < branches; i++)
+    {
+        for (size_t j = 0; j < branches; j++) REQUIRE(choice->IsCandidate(i, static_cast<char>('0' + j)) == (i == j));
+
+        REQUIRE(!choice->IsCandidate(i, std::nullopt));
+
+        std::string input{static_cast<char>('0' + i), '!'};
+        REQUIRE(matcher.Recognize("choice", input));
+    }
+}
+
+TEST_CASE("analysis::recursive", "[analysis]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["open"]  = "(";
+    builder["close"] = ")";
+    builder["x"]     = "x";
+    builder["group"] && "open" && "inner" && "close";
+    builder["inner"] || "group" || "x";
+
+    PatternMatcher matcher = builder.Finalize();
+
+    REQUIRE(matcher["inner"]->First() == CharClass::Of("(x"));
+    REQUIRE(!matcher["inner"]->IsNullable());
+    REQUIRE(matcher["group"]->First() == CharClass::Of("("));
+
+    REQUIRE(matcher.Recognize("group", "((x))"));
+    REQUIRE(!matcher.Recognize("group", "((x)"));
+}
+
+TEST_CASE("analysis::json", "[analysis]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    const Fragment* value = matcher["value-raw"];
+    REQUIRE(value->First() == CharClass::Of("[{tfn\"-0123456789"));
+
+    // Only the array branch is tried on a bracket
+    for (size_t i = 0; i < value->SubFragments().size(); i++)
+        REQUIRE(value->IsCandidate(i, '[') == (value->SubFragments()[i] == matcher["array"]));
+}
+
+TEST_CASE("analysis::lengths", "[analysis]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    REQUIRE(matcher["string-unicode-digits"]->MinLength() == 4);
+    REQUIRE(matcher["string-unicode-digits"]->MaxLength() == 4);
+    REQUIRE(matcher["string-unicode-escape"]->MinLength() == 5);
+    REQUIRE(matcher["string-unicode-escape"]->MaxLength() == 5);
+    REQUIRE(matcher["string-char"]->MinLength() == 1);
+    REQUIRE(matcher["string-char"]->MaxLength() == 6);
+    REQUIRE(matcher["string"]->MinLength() == 2);
+    REQUIRE(matcher["string"]->MaxLength() == RepeatCount::Unbounded);
+
+    // Arrays nest arbitrarily deep
+    REQUIRE(matcher["array"]->MinLength() == 2);
+    REQUIRE(matcher["array"]->MaxLength() == RepeatCount::Unbounded);
+
+    std::string input = GENERATE("\\u12", "\\u12G4", "\\u12aF", "\\\"", "\\u12aF  ");
+
+    auto expected = matcher.Match("string-char", input);
+    auto end      = matcher.Recognize("string-char", input);
+
+    REQUIRE(expected.has_value() == end.has_value());
+    if (expected)
+        REQUIRE(expected->myEnd == *end);
+
+    // The bytecode does not prune on lengths
+    Program program = matcher.Compile("string-char");
+    auto compiled   = program.Match(std::ranges::begin(input), std::ranges::end(input));
+
+    REQUIRE(compiled.has_value() == end.has_value());
+    if (compiled)
+        REQUIRE(compiled->myEnd == *end);
+}
+
+TEST_CASE("analysis::unanalyzed", "[analysis]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher<std::string> matcher;
+
+    Fragment& digits = matcher.EmplaceFragment("digits", CharClass::Of("0123456789"));
+    Fragment& word   = matcher.EmplaceFragment("word", std::string("word"));
+    Fragment& empty  = matcher.EmplaceFragment("empty", Fragment::Type::Sequence, std::vector<const Fragment*>{});
+    matcher.EmplaceFragment("root", Fragment::Type::Alternative, std::vector<const Fragment*>{&word, &digits, &empty});
+
+    std::string input = GENERATE("word", "7", "", "x");
+
+    auto expected = matcher.Match("root", input);
+    REQUIRE(expected);
+    REQUIRE(!matcher["root"]->IsAnalyzed());
+
+    matcher.Analyze();
+    REQUIRE(matcher["root"]->IsAnalyzed());
+
+    auto analyzed = matcher.Match("root", input);
+    REQUIRE(analyzed);
+    RequireSameTree(*expected, *analyzed);
+}
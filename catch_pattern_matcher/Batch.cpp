@@ -0,0 +1,83 @@
+#include <catch2/catch_all.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "catch_pattern_matcher/TreeEquality.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    std::vector<std::string> MakeDocuments(size_t aCount)
+    {
+        std::vector<std::string> out;
+
+        for (size_t i = 0; i < aCount; i++)
+        {
+            std::string document = "{ \"id\": " + std::to_string(i) + ", \"items\": [";
+            for (size_t j = 0; j < i % 17; j++) document += std::to_string(j * 31) + ", ";
+            document += "true] }";
+
+            // Every fifth document is cut short
+            if (i % 5 == 3)
+                document.resize(document.size() / 2);
+
+            out.push_back(document);
+        }
+
+        return out;
+    }
+}  // namespace
+
+TEST_CASE("batch::match", "[batch]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::vector<std::string> inputs = MakeDocuments(500);
+
+    BatchOptions options;
+    options.myThreads = 4;
+    options.myChunk   = 3;
+
+    auto results = matcher.MatchMany("value", inputs, options);
+    REQUIRE(results.size() == inputs.size());
+
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        CAPTURE(i);
+
+        auto expected = matcher.Match("value", inputs[i]);
+        REQUIRE(results[i].has_value() == expected.has_value());
+
+        if (expected)
+            RequireSameTree(*expected, *results[i]);
+    }
+}
+
+TEST_CASE("batch::recognize", "[batch]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::vector<std::string> documents = MakeDocuments(300);
+    std::vector<std::string_view> inputs(documents.begin(), documents.end());
+
+    BatchOptions options;
+    options.myThreads = GENERATE(1, 3, 8);
+
+    auto results = matcher.RecognizeMany("value", inputs, options);
+    REQUIRE(results.size() == inputs.size());
+
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        CAPTURE(i);
+        REQUIRE(results[i] == matcher.Recognize("value", inputs[i]));
+    }
+
+    std::vector<std::string_view> none;
+    REQUIRE(matcher.RecognizeMany("value", none, options).empty());
+}
@@ -0,0 +1,157 @@
+#include <catch2/catch_all.hpp>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "catch_pattern_matcher/TreeEquality.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    using Iterator = std::ranges::iterator_t<std::string>;
+
+    size_t CountNodes(const pattern_matcher::Success<Iterator>& aSuccess)
+    {
+        size_t count = 1;
+        for (const pattern_matcher::Success<Iterator>& child : aSuccess.mySubMatches) count += CountNodes(child);
+        return count;
+    }
+
+    bool Contains(const pattern_matcher::Success<Iterator>& aSuccess, const pattern_matcher::Fragment* aFragment)
+    {
+        for (const pattern_matcher::Success<Iterator>& child : aSuccess.mySubMatches)
+            if (child.myFragment == aFragment || Contains(child, aFragment))
+                return true;
+
+        return false;
+    }
+
+    pattern_matcher::PatternBuilder MakeSparseJsonParser()
+    {
+        pattern_matcher::PatternBuilder builder = MakeJsonParser();
+
+        for (std::string key : {"whitespace", "value-raw", "string-char", "string-content", "string-char-non-escaped",
+                                "digit", "digits", "array-cont", "array-continuations", "array-items", "array-content",
+                                "object-continuation", "object-continuations", "object-items", "object-content",
+                                "number-decimal", "number-fraction-optional", "number-exponent-optional",
+                                "minus-optional"})
+            builder[key].Transparent();
+
+        return builder;
+    }
+}  // namespace
+
+TEST_CASE("capture::basic", "[capture]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["a"]  = "a";
+    builder["b"]  = "b";
+    builder["c"]  = "c";
+    builder["ac"] || "a" || "c";
+    builder["ac"].Transparent();
+    builder["many"] = {"ac", {1, RepeatCount::Unbounded}};
+    builder["many"].Transparent();
+    builder["root"] && "many" && "b";
+
+    PatternMatcher matcher = builder.Finalize();
+
+    std::string input = "acab";
+
+    auto result = matcher.Match("root", input);
+    REQUIRE(result);
+
+    // The alternative and repeat are gone, leaving the literals they matched directly under the root
+    REQUIRE(result->mySubMatches.size() == 4);
+    REQUIRE(!Contains(*result, matcher["ac"]));
+    REQUIRE(!Contains(*result, matcher["many"]));
+    REQUIRE((*result)[3].myFragment == matcher["b"]);
+
+    ParseTree<Iterator> tree;
+    REQUIRE(matcher.Match("root", input, tree));
+    REQUIRE(tree.Size() == CountNodes(*result));
+    RequireSameTree<Iterator>(*result, tree.Root());
+
+    // The root is captured even when marked transparent
+    auto many = matcher.Match("many", input);
+    REQUIRE(many);
+    REQUIRE(many->myFragment == matcher["many"]);
+    REQUIRE(many->mySubMatches.size() == 3);
+}
+
+TEST_CASE("capture::json", "[capture]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher full   = MakeJsonParser().Finalize();
+    PatternMatcher sparse = MakeSparseJsonParser().Finalize();
+
+    std::string input = JsonSample;
+
+    auto fullResult   = full.Match("value", input);
+    auto sparseResult = sparse.Match("value", input);
+
+    REQUIRE(fullResult);
+    REQUIRE(sparseResult);
+    REQUIRE(sparseResult->myEnd == fullResult->myEnd);
+    REQUIRE(CountNodes(*sparseResult) < CountNodes(*fullResult));
+
+    ParseTree<Iterator> tree;
+    REQUIRE(sparse.Match("value", input, tree));
+    RequireSameTree<Iterator>(*sparseResult, tree.Root());
+
+    Program program = sparse.Compile("value");
+    auto compiled   = program.Match(std::ranges::begin(input), std::ranges::end(input));
+    REQUIRE(compiled);
+    RequireSameTree(*sparseResult, *compiled);
+
+    sparse.SetMemoPolicy(MemoPolicy::All);
+    auto memoized = sparse.Match("value", input);
+    REQUIRE(memoized);
+    RequireSameTree(*sparseResult, *memoized);
+
+    REQUIRE(sparse.Match("value", input, tree));
+    RequireSameTree<Iterator>(*sparseResult, tree.Root());
+}
+
+TEST_CASE("capture::bnf", "[capture]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = PatternBuilder::FromBNF(R"(
+_sign:
+        "+"
+        "-"
+
+_digits:
+        digit+
+
+digit:
+        "0"
+        "1"
+        "2"
+
+number:
+        _sign? _digits
+)");
+
+    std::string input = "-120";
+
+    auto result = matcher.Match("number", input);
+    REQUIRE(result);
+    REQUIRE(result->myEnd == input.end());
+
+    REQUIRE(!Contains(*result, matcher["_sign"]));
+    REQUIRE(!Contains(*result, matcher["_sign-optional"]));
+    REQUIRE(!Contains(*result, matcher["_digits"]));
+
+    size_t digits = 0;
+    for (Success<Iterator>& digit : result->SearchFor(matcher["digit"]))
+    {
+        (void)digit;
+        digits++;
+    }
+
+    REQUIRE(digits == 3);
+}
@@ -0,0 +1,88 @@
+#include <catch2/catch_all.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "catch_pattern_matcher/TreeEquality.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+TEST_CASE("grammar::freeze", "[grammar]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = JsonSample;
+
+    auto expected = matcher.Match("value", input);
+    REQUIRE(expected);
+
+    const Fragment* value = matcher["value"];
+
+    std::shared_ptr<const CompiledGrammar<std::string>> grammar = std::move(matcher).Freeze();
+
+    // The packed fragments move along with the pool
+    REQUIRE((*grammar)["value"] == value);
+    REQUIRE(grammar->Pool().Contains((*grammar)["value"]));
+    REQUIRE((*grammar)["missing"] == nullptr);
+
+    auto result = grammar->Match("value", input);
+    REQUIRE(result);
+    RequireSameTree(*expected, *result);
+
+    ParseTree<std::string::iterator> tree;
+    REQUIRE(grammar->Match("value", input, tree));
+    RequireSameTree<std::string::iterator>(*expected, tree.Root());
+
+    REQUIRE(grammar->Recognize("value", input) == input.end());
+    REQUIRE(!grammar->Recognize("value", "[1, 2"));
+}
+
+TEST_CASE("grammar::unpacked", "[grammar]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher<std::string> matcher;
+    matcher.EmplaceFragment("a", std::string("a"));
+    matcher.EmplaceFragment("ab", Fragment::Type::Sequence, std::vector<const Fragment*>{matcher["a"], matcher['b']});
+
+    REQUIRE(!matcher.IsPacked());
+
+    auto grammar = std::move(matcher).Freeze();
+
+    REQUIRE(grammar->Pool().Contains((*grammar)["ab"]));
+    REQUIRE(grammar->Pool().Contains((*grammar)['b']));
+    REQUIRE((*grammar)['c'] == nullptr);
+    REQUIRE(grammar->Recognize("ab", "abc"));
+    REQUIRE(!grammar->Recognize("ab", "ba"));
+}
+
+TEST_CASE("grammar::threads", "[grammar]")
+{
+    using namespace pattern_matcher;
+
+    std::shared_ptr<const CompiledGrammar<std::string>> grammar = MakeJsonParser().Finalize().Freeze();
+
+    std::vector<std::string> inputs;
+    for (size_t i = 0; i < 64; i++)
+        inputs.push_back("[" + std::to_string(i) + ", { \"key\": \"" + std::string(i, 'x') + "\" }, " +
+                         (i % 3 ? "true]" : "tru]"));
+
+    std::vector<bool> expected;
+    for (std::string& input : inputs) expected.push_back(grammar->Recognize("value", input) == input.end());
+
+    std::vector<size_t> mismatches(8, 0);
+    {
+        std::vector<std::jthread> threads;
+        for (size_t t = 0; t < mismatches.size(); t++)
+            threads.emplace_back([&, t, grammar]() {
+                for (size_t round = 0; round < 16; round++)
+                    for (size_t i = 0; i < inputs.size(); i++)
+                        if ((grammar->Recognize("value", inputs[i]) == inputs[i].end()) != expected[i])
+                            mismatches[t]++;
+            });
+    }
+
+    for (size_t count : mismatches) REQUIRE(count == 0);
+}
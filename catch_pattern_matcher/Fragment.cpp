@@ -1,5 +1,6 @@
 
 #include <catch2/catch_all.hpp>
+#include <deque>
 #include <stack>
 
 #include "pattern_matcher/PatternMatcher.h"
@@ -9,10 +10,12 @@ namespace pattern_matcher
     std::optional<Success<std::string_view::iterator>> Match(Fragment& aFragment, std::string_view aText)
     {
         std::stack<MatchContext<std::string_view::iterator>> contexts;
+        std::stack<std::vector<Success<std::string_view::iterator>>> children;
 
         std::string_view::iterator end = std::ranges::end(aText);
 
         contexts.push(aFragment.BeginMatch(std::ranges::begin(aText)));
+        children.emplace();
 
         Result<std::string_view::iterator> lastResult;
 
@@ -24,13 +27,27 @@ namespace pattern_matcher
 
             switch (lastResult.GetType())
             {
-                case MatchResultType::Success:
+                case MatchResultType::Success: {
+                    Success<std::string_view::iterator> node = lastResult.TakeSuccess();
+                    node.mySubMatches                        = std::move(children.top());
+                    contexts.pop();
+                    children.pop();
+
+                    if (contexts.empty())
+                        return node;
+
+                    children.top().push_back(std::move(node));
+                }
+                break;
+
                 case MatchResultType::Failure:
                     contexts.pop();
+                    children.pop();
                     break;
 
                 case MatchResultType::InProgress:
-                    contexts.push(lastResult.Context());
+                    contexts.push(lastResult.TakeContext());
+                    children.emplace();
                     lastResult = {};
                     break;
                 case MatchResultType::None:
@@ -42,7 +59,7 @@ namespace pattern_matcher
         switch (lastResult.GetType())
         {
             case MatchResultType::Success:
-                return lastResult.Success();
+                return lastResult.TakeSuccess();
 
             case MatchResultType::Failure:
                 return {};
@@ -70,7 +87,7 @@ namespace pattern_matcher
             REQUIRE(*start.myAt == 'a');
             REQUIRE(start.myIndex == 0);
             REQUIRE(start.myFragment == &literal);
-            REQUIRE(start.mySubMatches.empty());
+            REQUIRE(!start.myUnchecked);
         }
 
         {
@@ -87,6 +104,59 @@ namespace pattern_matcher
         REQUIRE(*Match(literal, "abc") == "a");
     }
 
+    TEST_CASE("fragment::string", "[fragments]")
+    {
+        Fragment keyword(std::string("null"));
+
+        REQUIRE(!Match(keyword, ""));
+        REQUIRE(!Match(keyword, "nul"));
+        REQUIRE(!Match(keyword, "nulL"));
+        REQUIRE(Match(keyword, "null")->myFragment == &keyword);
+        REQUIRE(*Match(keyword, "nullable") == "null");
+        REQUIRE(Match(keyword, "null")->mySubMatches.empty());
+
+        std::string text = "a string longer than sixteen bytes";
+        Fragment sentence(text);
+
+        REQUIRE(*Match(sentence, text + "!") == text);
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            std::string wrong = text;
+            wrong[i]          = '?';
+            REQUIRE(!Match(sentence, wrong));
+        }
+
+        // Iterators that are not contiguous compare one element at a time
+        std::deque<char> deque(std::begin(text), std::end(text));
+        MatchContext<std::deque<char>::iterator> ctx = sentence.BeginMatch(std::begin(deque));
+        REQUIRE(sentence.ResumeMatch(ctx, {}, std::end(deque)).GetType() == MatchResultType::Success);
+
+        deque.back() = '?';
+        ctx          = sentence.BeginMatch(std::begin(deque));
+        REQUIRE(sentence.ResumeMatch(ctx, {}, std::end(deque)).GetType() == MatchResultType::Failure);
+    }
+
+    TEST_CASE("fragment::char_class", "[fragments]")
+    {
+        Fragment digit(CharClass::Of("0123456789"));
+        Fragment other(CharClass::NotOf("\"\\"));
+
+        REQUIRE(digit.GetClass().Count() == 10);
+        REQUIRE(other.GetClass().Count() == 254);
+
+        REQUIRE(!Match(digit, ""));
+        REQUIRE(!Match(digit, "a"));
+        REQUIRE(*Match(digit, "42") == "4");
+        REQUIRE(Match(digit, "4")->myFragment == &digit);
+        REQUIRE(Match(digit, "4")->mySubMatches.empty());
+
+        REQUIRE(!Match(other, "\""));
+        REQUIRE(!Match(other, "\\"));
+        REQUIRE(*Match(other, "a") == "a");
+        REQUIRE(*Match(other, "\xff") == "\xff");
+        REQUIRE(*Match(other, std::string_view("\0", 1)) == std::string_view("\0", 1));
+    }
+
     TEST_CASE("fragment::sequence", "[fragments]")
     {
         Fragment a('a');
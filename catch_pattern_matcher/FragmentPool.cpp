@@ -0,0 +1,75 @@
+#include <catch2/catch_all.hpp>
+#include <string>
+#include <unordered_set>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    using Iterator = std::ranges::iterator_t<std::string>;
+
+    // Checks that aPacked mirrors aOriginal node for node, mapping the original fragments into the pool
+    void RequirePackedTree(const pattern_matcher::FragmentPool& aPool, const pattern_matcher::Success<Iterator>& aOriginal,
+                           const pattern_matcher::Success<Iterator>& aPacked)
+    {
+        REQUIRE(aPool.Find(aOriginal.myFragment) == aPacked.myFragment);
+        REQUIRE(aOriginal.myBegin == aPacked.myBegin);
+        REQUIRE(aOriginal.myEnd == aPacked.myEnd);
+        REQUIRE(aOriginal.mySubMatches.size() == aPacked.mySubMatches.size());
+
+        for (size_t i = 0; i < aOriginal.mySubMatches.size(); i++) RequirePackedTree(aPool, aOriginal[i], aPacked[i]);
+    }
+}  // namespace
+
+TEST_CASE("pool::layout", "[pool]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+    REQUIRE(matcher.IsPacked());
+
+    const FragmentPool& pool = matcher.Pool();
+
+    // Every fragment reachable from the root, literals included, is in the one array
+    std::vector<const Fragment*> stack = {matcher["value"]};
+    std::unordered_set<const Fragment*> seen;
+
+    while (!stack.empty())
+    {
+        const Fragment* fragment = stack.back();
+        stack.pop_back();
+
+        if (!seen.insert(fragment).second)
+            continue;
+
+        REQUIRE(pool.Contains(fragment));
+        REQUIRE(fragment->IsPacked());
+
+        for (const Fragment* sub : fragment->SubFragments()) stack.push_back(sub);
+    }
+
+    REQUIRE(matcher["char-" + std::to_string('[')] == matcher["array"]->SubFragments()[0]);
+
+    // Small enough to stay in the second level cache, with the parts that vary in size kept beside the fragments
+    REQUIRE(pool.Footprint() < 256 * 1024);
+    REQUIRE(sizeof(Fragment) <= 80);
+}
+
+TEST_CASE("pool::match", "[pool]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = GENERATE(JsonSample, "[]", "  12  ", "[1, 2", "");
+
+    const Fragment* original = &matcher.Fragments().at("value");
+
+    auto expected = matcher.Match(original, input);
+    auto packed   = matcher.Match("value", input);
+
+    REQUIRE(expected.has_value() == packed.has_value());
+    if (expected)
+        RequirePackedTree(matcher.Pool(), *expected, *packed);
+}
@@ -0,0 +1,135 @@
+#include "pattern_matcher/Generator.h"
+
+#include <catch2/catch_all.hpp>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    bool Accepts(pattern_matcher::PatternMatcher<>& aMatcher, const std::string& aInput)
+    {
+        auto end = aMatcher.Recognize("value", aInput);
+        return end && *end == aInput.end();
+    }
+}  // namespace
+
+TEST_CASE("generator::json", "[generator]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    GeneratorOptions options;
+    options.myMaxDepth  = GENERATE(1, 4, 8);
+    options.myMaxRepeat = GENERATE(0, 3, 6);
+    options.mySeed      = 1234;
+
+    InputGenerator generator(matcher["value"], options);
+
+    for (size_t i = 0; i < 50; i++)
+    {
+        std::string input;
+        generator.Generate(input);
+
+        CAPTURE(input);
+        REQUIRE(Accepts(matcher, input));
+    }
+
+    // The same seed makes the same inputs
+    InputGenerator first(matcher["value"], options);
+    InputGenerator second(matcher["value"], options);
+
+    std::string a;
+    std::string b;
+    first.GenerateRecords(a, 4'096);
+    second.GenerateRecords(b, 4'096);
+
+    REQUIRE(a.size() >= 4'096);
+    REQUIRE(a == b);
+}
+
+TEST_CASE("generator::fill", "[generator]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    GeneratorOptions options;
+    options.mySeed = GENERATE(1, 2, 3);
+
+    InputGenerator generator(matcher["value"], options);
+
+    // Steered into an array however unlikely that is, which then grows until the target size
+    std::string input;
+    generator.Generate(input, 1 << 20, matcher["array-continuations"]);
+
+    REQUIRE(input.size() >= 1 << 20);
+    REQUIRE(input.size() < (1 << 20) + (1 << 16));
+    REQUIRE(Accepts(matcher, input));
+}
+
+TEST_CASE("generator::mutate", "[generator]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    GeneratorOptions options;
+    options.mySeed = 99;
+
+    InputGenerator generator(matcher["value"], options);
+
+    size_t rejected = 0;
+    for (size_t i = 0; i < 200; i++)
+    {
+        std::string input;
+        generator.Generate(input);
+
+        std::string valid = input;
+        if (generator.MutateInvalid(input, [&](const std::string& aInput) { return Accepts(matcher, aInput); }))
+        {
+            CAPTURE(valid, input);
+            REQUIRE(!Accepts(matcher, input));
+            REQUIRE(input != valid);
+            rejected++;
+        }
+        else
+        {
+            REQUIRE(input == valid);
+        }
+    }
+
+    REQUIRE(rejected > 150);
+}
+
+TEST_CASE("generator::shortest", "[generator]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["a"]    = "a";
+    builder["b"]    = "b";
+    builder["loop"] || "nested" || "b";
+    builder["nested"] && "a" && "loop" && "a";
+
+    PatternMatcher matcher = builder.Finalize();
+
+    GeneratorOptions options;
+    options.myMaxDepth = 3;
+
+    InputGenerator generator(matcher["loop"], options);
+
+    // Past the depth limit only the way out is taken
+    for (size_t i = 0; i < 100; i++)
+    {
+        std::string input;
+        generator.Generate(input);
+
+        REQUIRE(input.size() % 2 == 1);
+        REQUIRE(input.size() <= 7);
+        REQUIRE(input[input.size() / 2] == 'b');
+    }
+}
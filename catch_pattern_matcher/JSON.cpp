@@ -91,4 +91,39 @@ TEST_CASE("integration::json", "")
     {
         REQUIRE_FALSE(e.what());
     }
+}
+
+TEST_CASE("integration::json_file", "")
+{
+    pattern_matcher::PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::filesystem::path file = GENERATE(Files(CATCH_JSON_TEST_CASES_PATH));
+
+    char type = file.filename().c_str()[0];
+
+    CAPTURE(file.filename());
+
+    // Matches the file as it is on disk, trailing newline included
+    try
+    {
+        switch (type)
+        {
+            case 'i':
+                break;
+            case 'n': {
+                auto match = matcher.MatchFile("value", file);
+                if (match)
+                    REQUIRE(!(match->myMatch == match->myFile->View()));
+            }
+            break;
+            case 'y':
+                auto result = matcher.MatchFile("value", file);
+                REQUIRE(result);
+                break;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        REQUIRE_FALSE(e.what());
+    }
 }
\ No newline at end of file
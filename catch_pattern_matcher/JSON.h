@@ -1,9 +1,36 @@
 #pragma once
 
+#include <array>
 #include <string>
 
 #include "pattern_matcher/PatternBuilder.h"
 
+// Exercises every kind of json value, including an escape and a multi-byte character
+inline constexpr const char* JsonSample = R"({ "a": [1, 2.5e3, -0.1E-2, true, false, null], "b": { "c": "då\n" } })";
+
+// Small grammar covering literals, alternatives, sequences, repeats and classes
+inline pattern_matcher::PatternBuilder MakeAbcParser()
+{
+    pattern_matcher::PatternBuilder builder;
+
+    builder["a"] = "a";
+    builder["b"] = "b";
+    builder["c"] = "c";
+
+    builder["any"] || "a" || "b" || "c";
+    builder["all"] && "a" && "b" && "c";
+    builder["some"] = {"any", {1, 3}};
+    builder["many"] = {"all", {0, pattern_matcher::RepeatCount::Unbounded}};
+    builder["class"].OneOf("xyz");
+    builder["mixed"] || "a" || "b" || "all" || "class";
+
+    return builder;
+}
+
+inline constexpr std::array<const char*, 7> AbcRoots   = {"a", "any", "all", "some", "many", "class", "mixed"};
+inline constexpr std::array<const char*, 10> AbcInputs = {"", "a", "b", "c", "abc", "abcabc", "cba", "aaaa", "xa",
+                                                          "yabc"};
+
 inline pattern_matcher::PatternBuilder MakeJsonParser()
 {
     pattern_matcher::PatternBuilder builder;
@@ -0,0 +1,144 @@
+
+#include <catch2/catch_all.hpp>
+#include <limits>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    template<class Key>
+    void RequireSameEnd(pattern_matcher::PatternMatcher<Key>& aMatcher, const pattern_matcher::JitProgram& aProgram,
+                        Key aRoot, const std::string& aInput)
+    {
+        auto expected = aMatcher.Match(aRoot, aInput);
+        auto actual   = aProgram.Match(aInput);
+
+        CAPTURE(aInput);
+        REQUIRE(expected.has_value() == actual.has_value());
+
+        if (expected)
+            REQUIRE(expected->myEnd == *actual);
+    }
+}  // namespace
+
+TEST_CASE("jit::basic", "[jit]")
+{
+    using namespace pattern_matcher;
+
+    if (!JitProgram::Supported())
+        SKIP("No JIT on this platform");
+
+    PatternMatcher matcher = MakeAbcParser().Finalize();
+
+    for (std::string root : AbcRoots)
+    {
+        CAPTURE(root);
+        std::optional<JitProgram> program = matcher.Jit(root);
+        REQUIRE(program);
+
+        for (std::string input : AbcInputs) RequireSameEnd(matcher, *program, root, input);
+    }
+}
+
+TEST_CASE("jit::string", "[jit]")
+{
+    using namespace pattern_matcher;
+
+    if (!JitProgram::Supported())
+        SKIP("No JIT on this platform");
+
+    const std::string text = "abcdefghijklmnopqrstuvwxyz";
+
+    size_t length = GENERATE(1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 26);
+
+    PatternBuilder builder;
+    builder["word"] = text.substr(0, length);
+
+    PatternMatcher matcher = builder.Finalize();
+
+    std::optional<JitProgram> program = matcher.Jit("word");
+    REQUIRE(program);
+
+    RequireSameEnd(matcher, *program, std::string("word"), text);
+    RequireSameEnd(matcher, *program, std::string("word"), text.substr(0, length - 1));
+
+    for (size_t i = 0; i < length; i++)
+    {
+        std::string wrong = text;
+        wrong[i]          = '?';
+        RequireSameEnd(matcher, *program, std::string("word"), wrong);
+    }
+}
+
+TEST_CASE("jit::json", "[jit]")
+{
+    using namespace pattern_matcher;
+
+    if (!JitProgram::Supported())
+        SKIP("No JIT on this platform");
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::optional<JitProgram> program = matcher.Jit("value");
+    REQUIRE(program);
+
+    std::string input = GENERATE(JsonSample, "[]", "[1, 2,]", "{\"a\" 1}", "\"unterminated", "  12  ",
+                                 "[[[[[[]]]]]]", "01");
+
+    RequireSameEnd(matcher, *program, std::string("value"), input);
+}
+
+TEST_CASE("jit::depth", "[jit]")
+{
+    using namespace pattern_matcher;
+
+    if (!JitProgram::Supported())
+        SKIP("No JIT on this platform");
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::optional<JitProgram> program = matcher.Jit("value");
+    REQUIRE(program);
+
+    std::string deep = std::string(10'000, '[') + std::string(10'000, ']');
+
+    REQUIRE(!program->Match(deep));
+    REQUIRE(program->Match(deep, 1'000'000));
+
+    // Deeper than any thread stack holds, stopped by the stack check instead of overflowing
+    std::string deeper = std::string(10'000'000, '[') + std::string(10'000'000, ']');
+    REQUIRE(!program->Match(deeper, std::numeric_limits<size_t>::max()));
+}
+
+TEST_CASE("jit::unsupported", "[jit]")
+{
+    using namespace pattern_matcher;
+
+    if (!JitProgram::Supported())
+        SKIP("No JIT on this platform");
+
+    PatternBuilder builder;
+
+    builder["a"]     = "a";
+    builder["maybe"] = {"a", {0, 1}};
+    builder["loop"]  = {"maybe", {0, RepeatCount::Unbounded}};
+    builder["some"]  = {"maybe", {0, 4}};
+
+    PatternMatcher matcher = builder.Finalize();
+
+    // Match runs out of steps on the empty iterations and fails, the JIT can't do the same so it does not compile it
+    std::string input = "aab";
+    REQUIRE(!matcher.Match("loop", input, 2'048, 100'000));
+    REQUIRE(!matcher.Jit("loop"));
+
+    // A bounded repeat stops on its own
+    std::optional<JitProgram> some = matcher.Jit("some");
+    REQUIRE(some);
+    RequireSameEnd(matcher, *some, std::string("some"), input);
+
+    // Neither does it compile fragments it has no code for
+    Fragment none;
+    REQUIRE(!JitProgram::Compile(&none));
+}
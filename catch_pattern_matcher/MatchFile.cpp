@@ -0,0 +1,79 @@
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    // Writes aContent to a file in the temp directory, removed again when destroyed
+    class TemporaryFile
+    {
+    public:
+        TemporaryFile(std::string aName, std::string_view aContent)
+            : myPath(std::filesystem::temp_directory_path() / aName)
+        {
+            std::ofstream out(myPath, std::ios::binary);
+            out.write(aContent.data(), static_cast<std::streamsize>(aContent.size()));
+        }
+
+        ~TemporaryFile() { std::filesystem::remove(myPath); }
+
+        const std::filesystem::path& Path() const { return myPath; }
+
+    private:
+        std::filesystem::path myPath;
+    };
+}  // namespace
+
+TEST_CASE("file::json", "[file]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = JsonSample;
+
+    std::optional<FileMatch> result;
+    {
+        TemporaryFile file("pattern_matcher_file_json.json", input);
+        result = matcher.MatchFile("value", file.Path());
+    }
+
+    // The mapping outlives the file being removed and is kept alive by the result
+    REQUIRE(result);
+    REQUIRE(result->myMatch == input);
+    REQUIRE((*result)->myEnd == result->myFile->end());
+
+    auto expected = matcher.Match("value", input);
+    REQUIRE(expected);
+    REQUIRE((*result)->mySubMatches.size() == expected->mySubMatches.size());
+}
+
+TEST_CASE("file::edges", "[file]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    {
+        TemporaryFile file("pattern_matcher_file_empty.json", "");
+
+        std::shared_ptr<const MappedFile> mapped = MappedFile::Open(file.Path());
+        REQUIRE(mapped);
+        REQUIRE(mapped->Empty());
+        REQUIRE(mapped->begin() == mapped->end());
+
+        REQUIRE(!matcher.MatchFile("value", file.Path()));
+    }
+
+    {
+        TemporaryFile file("pattern_matcher_file_invalid.json", "[1, 2");
+        REQUIRE(!matcher.MatchFile("value", file.Path()));
+    }
+
+    REQUIRE(!MappedFile::Open(std::filesystem::temp_directory_path() / "pattern_matcher_file_missing.json"));
+    REQUIRE(!matcher.MatchFile("value", std::filesystem::temp_directory_path() / "pattern_matcher_file_missing.json"));
+}
@@ -0,0 +1,186 @@
+#include <catch2/catch_all.hpp>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "catch_pattern_matcher/TreeEquality.h"
+#include "pattern_matcher/CompiledGrammar.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    // The continuations of a JSON array, with strings full of separators so some cuts land on false sync points
+    std::string MakeContinuations(std::mt19937& aRandom, size_t aItems)
+    {
+        std::string out;
+
+        for (size_t i = 0; i < aItems; i++)
+        {
+            out += aRandom() % 3 ? ", " : " ,\n";
+
+            switch (aRandom() % 4)
+            {
+                case 0:
+                    out += std::to_string(aRandom() % 100'000);
+                    break;
+                case 1:
+                    out += "\"a, 1, 2, 3, 4, \\\", 5\"";
+                    break;
+                case 2:
+                    out += "[1, 2, {\"k\": \", 3\"}, [4, 5]]";
+                    break;
+                case 3:
+                    out += "{ \"x\": true, \"y\": null }";
+                    break;
+            }
+        }
+
+        return out;
+    }
+}  // namespace
+
+TEST_CASE("parallel::json", "[parallel]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::mt19937 random(GENERATE(1u, 2u, 3u, 4u, 5u));
+    std::string input = MakeContinuations(random, 400);
+
+    SplitOptions options;
+    options.myThreads      = GENERATE(2, 5, 16);
+    options.myMinChunkSize = 64;
+
+    auto expected = matcher.Match("array-continuations", input);
+    REQUIRE(expected);
+
+    SplitCounters counters;
+    auto result = matcher.MatchParallel("array-continuations", "array-cont", input, options, &counters);
+    REQUIRE(result);
+    RequireSameTree(*expected, *result);
+
+    REQUIRE(counters.myChunks == options.myThreads);
+    REQUIRE(counters.myAccepted + counters.myRejected == counters.myChunks);
+    REQUIRE(counters.myAccepted >= 1);
+}
+
+TEST_CASE("parallel::early_end", "[parallel]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::mt19937 random(7);
+    std::string input = MakeContinuations(random, 200) + ", }" + MakeContinuations(random, 200);
+
+    SplitOptions options;
+    options.myThreads      = 8;
+    options.myMinChunkSize = 64;
+
+    auto expected = matcher.Match("array-continuations", input);
+    REQUIRE(expected);
+    REQUIRE(expected->myEnd != input.end());
+
+    // The chunks after the broken item are matched but never used
+    SplitCounters counters;
+    auto result = matcher.MatchParallel("array-continuations", "array-cont", input, options, &counters);
+    REQUIRE(result);
+    RequireSameTree(*expected, *result);
+    REQUIRE(counters.myRejected > 0);
+}
+
+TEST_CASE("parallel::bounds", "[parallel]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["item"] = "ab";
+    builder["some"] = {"item", {3, 40}};
+    builder["many"] = {"item", {300, RepeatCount::Unbounded}};
+
+    PatternMatcher matcher = builder.Finalize();
+
+    std::string input;
+    for (size_t i = 0; i < 100; i++) input += "ab";
+
+    SplitOptions options;
+    options.myThreads      = 4;
+    options.myMinChunkSize = 16;
+
+    auto expected = matcher.Match("some", input);
+    auto result   = matcher.MatchParallel("some", "item", input, options);
+    REQUIRE(result);
+    REQUIRE(result->mySubMatches.size() == 40);
+    RequireSameTree(*expected, *result);
+
+    REQUIRE(!matcher.Match("many", input));
+    REQUIRE(!matcher.MatchParallel("many", "item", input, options));
+
+    // Too small to be worth cutting up
+    options.myMinChunkSize = 1 << 16;
+    SplitCounters counters;
+    REQUIRE(matcher.MatchParallel("some", "item", input, options, &counters));
+    REQUIRE(counters.myChunks == 0);
+}
+
+TEST_CASE("parallel::nullable_item", "[parallel]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["x"]    = "x";
+    builder["item"] = {"x", {0, 1}};
+    builder["some"] = {"item", {0, 50}};
+
+    PatternMatcher matcher = builder.Finalize();
+
+    std::string input(200, 'x');
+    input += "y";
+
+    SplitOptions options;
+    options.myThreads      = 4;
+    options.myMinChunkSize = 16;
+
+    // Matched sequentially, the empty items after the last x are repeated up to the maximum as in Match
+    SplitCounters counters;
+    auto expected = matcher.Match("some", input);
+    auto result   = matcher.MatchParallel("some", "item", input, options, &counters);
+    REQUIRE(result);
+    RequireSameTree(*expected, *result);
+    REQUIRE(counters.myChunks == 0);
+}
+
+TEST_CASE("parallel::max_steps", "[parallel]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["item"] = "ab";
+    builder["many"] = {"item", {0, RepeatCount::Unbounded}};
+
+    std::shared_ptr<const CompiledGrammar<std::string>> grammar = builder.Finalize().Freeze();
+
+    std::string input;
+    for (size_t i = 0; i < 1'000; i++) input += "ab";
+
+    SplitOptions options;
+    options.myThreads      = 4;
+    options.myMinChunkSize = 64;
+
+    // Each item is cheap on its own, together they go over the budget
+    options.myMaxSteps = 1'000;
+    REQUIRE(!grammar->Match("many", input, 2'048, options.myMaxSteps));
+    REQUIRE(!grammar->MatchParallel("many", "item", input, options));
+
+    options.myMaxSteps = 1'000'000;
+    SplitCounters counters;
+    auto result = grammar->MatchParallel("many", "item", input, options, &counters);
+    REQUIRE(result);
+    REQUIRE(result->mySubMatches.size() == 1'000);
+    REQUIRE(counters.myChunks == 4);
+}
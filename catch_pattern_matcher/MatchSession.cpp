@@ -0,0 +1,94 @@
+#include <catch2/catch_all.hpp>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    std::optional<size_t> Stream(pattern_matcher::PatternMatcher<std::string>& aMatcher, std::string_view aInput,
+                                 size_t aChunk)
+    {
+        pattern_matcher::MatchSession session = aMatcher.Stream("value");
+
+        for (size_t at = 0; at < aInput.size(); at += aChunk) session.Feed(aInput.substr(at, aChunk));
+
+        return session.Finish();
+    }
+}  // namespace
+
+TEST_CASE("session::json", "[session]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = GENERATE(JsonSample, R"("d\u00e5\n")",
+                                 "[]", "  12  ", "[[[[[[]]]]]]", "[1, 2", "{ \"a\" }", "", "nul", "true false",
+                                 "\"\\u12\"");
+
+    std::optional<std::string::iterator> expected = matcher.Recognize("value", input);
+
+    for (size_t chunk : {1, 2, 3, 7, 64})
+    {
+        std::optional<size_t> end = Stream(matcher, input, chunk);
+
+        REQUIRE(expected.has_value() == end.has_value());
+        if (expected)
+            REQUIRE(*end == static_cast<size_t>(*expected - input.begin()));
+    }
+}
+
+TEST_CASE("session::bounded", "[session]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    MatchSession session = matcher.Stream("value");
+    session.Feed("[");
+
+    std::string item = R"({ "id": 12345, "name": "some name", "tags": ["a", "b"] }, )";
+    size_t mostRetained = 0;
+
+    for (size_t i = 0; i < 10'000; i++)
+    {
+        session.Feed(item);
+        mostRetained = std::max(mostRetained, session.Retained());
+    }
+
+    session.Feed("1]");
+
+    REQUIRE(session.Released() > 10'000 * item.size() / 2);
+    REQUIRE(mostRetained < 4 * item.size());
+
+    std::optional<size_t> end = session.Finish();
+    REQUIRE(end);
+    REQUIRE(*end == 1 + 10'000 * item.size() + 2);
+}
+
+TEST_CASE("session::early", "[session]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["a"] = "a";
+    builder["b"] = "b";
+    builder["root"] && "a" && "b";
+
+    PatternMatcher matcher = builder.Finalize();
+
+    // Decided as soon as the mismatch is seen
+    MatchSession failing = matcher.Stream("root");
+    failing.Feed("a");
+    REQUIRE(!failing.Done());
+    failing.Feed("c");
+    REQUIRE(failing.Done());
+    REQUIRE(!failing.Finish());
+
+    MatchSession matching = matcher.Stream("root");
+    matching.Feed("abc");
+    REQUIRE(matching.Done());
+    REQUIRE(matching.Finish() == 2);
+}
@@ -0,0 +1,190 @@
+
+#include <catch2/catch_all.hpp>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "catch_pattern_matcher/TreeEquality.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    pattern_matcher::PatternBuilder MakeBacktrackingParser()
+    {
+        pattern_matcher::PatternBuilder builder;
+
+        builder["a"] = "a";
+        builder["b"] = "b";
+        builder["c"] = "c";
+
+        builder["item"].Memoize() = {"a", {0, pattern_matcher::RepeatCount::Unbounded}};
+        builder["first"] && "item" && "b";
+        builder["second"] && "item" && "c";
+        builder["choice"] || "first" || "second";
+
+        return builder;
+    }
+}  // namespace
+
+TEST_CASE("memo::none", "[memo]")
+{
+    pattern_matcher::PatternMatcher matcher = MakeBacktrackingParser().Finalize();
+
+    REQUIRE(matcher.GetMemoPolicy() == pattern_matcher::MemoPolicy::None);
+    REQUIRE(matcher.Match("choice", "aaaac"));
+    REQUIRE(matcher.LastMemoCounters().myHits == 0);
+    REQUIRE(matcher.LastMemoCounters().myMisses == 0);
+    REQUIRE(matcher.LastMemoCounters().myStores == 0);
+}
+
+TEST_CASE("memo::flagged", "[memo]")
+{
+    pattern_matcher::PatternMatcher matcher = MakeBacktrackingParser().Finalize();
+    std::string input = "aaaac";
+
+    auto expected = matcher.Match("choice", input);
+    REQUIRE(expected);
+
+    matcher.SetMemoPolicy(pattern_matcher::MemoPolicy::Flagged);
+    auto memoized = matcher.Match("choice", input);
+    REQUIRE(memoized);
+    RequireSameTree(*expected, *memoized);
+
+    // "item" is entered at offset 0 by both branches of "choice", nothing else is flagged
+    REQUIRE(matcher.LastMemoCounters().myHits == 1);
+    REQUIRE(matcher.LastMemoCounters().myMisses == 1);
+    REQUIRE(matcher.LastMemoCounters().myStores == 1);
+}
+
+TEST_CASE("memo::all", "[memo]")
+{
+    pattern_matcher::PatternMatcher matcher = MakeBacktrackingParser().Finalize();
+    std::string input = "aaaac";
+
+    auto expected = matcher.Match("choice", input);
+
+    matcher.SetMemoPolicy(pattern_matcher::MemoPolicy::All);
+    auto memoized = matcher.Match("choice", input);
+    REQUIRE(memoized);
+    RequireSameTree(*expected, *memoized);
+
+    REQUIRE(matcher.LastMemoCounters().myHits >= 1);
+    REQUIRE(matcher.LastMemoCounters().myMisses > 1);
+
+    REQUIRE(!matcher.Match("choice", "aaaa"));
+}
+
+TEST_CASE("memo::json", "[memo]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+    std::string input      = R"({ "a": [1, 2.5e3, true, false, null], "b": { "c": "då" }, "e": [] })";
+
+    auto expected = matcher.Match("value", input);
+    REQUIRE(expected);
+    REQUIRE(*expected == input);
+
+    MemoPolicy policy = GENERATE(MemoPolicy::All, MemoPolicy::Flagged, MemoPolicy::Adaptive);
+    matcher.SetMemoPolicy(policy);
+
+    auto memoized = matcher.Match("value", input);
+    REQUIRE(memoized);
+    RequireSameTree(*expected, *memoized);
+}
+
+TEST_CASE("memo::depth_limit", "[memo]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["a"] = "a";
+    builder["b"] = "b";
+
+    // "item" is first tried deep down "deep", where the depth limit cuts it off, then again at the same offset
+    // through "shallow" where it fits. The input is long enough for "deep" not to be skipped by its length.
+    builder["pair"] && "a" && "a";
+    builder["item"] && "pair" && "a";
+    builder["deep-3"] && "item" && "b";
+    builder["deep-2"] && "deep-3" && "b";
+    builder["deep-1"] && "deep-2" && "b";
+    builder["deep"] && "deep-1" && "b";
+    builder["shallow"] && "item" && "a";
+    builder["choice"] || "deep" || "shallow";
+
+    PatternMatcher matcher = builder.Finalize();
+
+    std::string input = "aaaabbbb";
+    MemoPolicy policy  = GENERATE(MemoPolicy::All, MemoPolicy::Adaptive);
+
+    size_t found = 0;
+    for (size_t depth = 1; depth < 10; depth++)
+    {
+        CAPTURE(depth);
+
+        matcher.SetMemoPolicy(MemoPolicy::None);
+        auto expected = matcher.Match("choice", input, depth);
+
+        matcher.SetMemoPolicy(policy);
+
+        auto memoized = matcher.Match("choice", input, depth);
+        REQUIRE(expected.has_value() == memoized.has_value());
+        found += expected.has_value();
+        if (expected)
+            RequireSameTree(*expected, *memoized);
+    }
+
+    REQUIRE(found > 0);
+}
+
+TEST_CASE("memo::depth_reuse", "[memo]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["a"]    = "a";
+    builder["b"]    = "b";
+    builder["bang"] = "!";
+
+    // "item" first matches close to the root through "near", which then fails. It is tried again at the same offset
+    // further down "far", where near the limit it no longer fits and the cached success must not be replayed.
+    builder["pair"] && "a" && "a";
+    builder["item"] && "pair" && "a";
+    builder["near"] && "item" && "bang";
+    builder["far-3"] && "item" && "b";
+    builder["far-2"] && "far-3" && "b";
+    builder["far-1"] && "far-2" && "b";
+    builder["far"] && "far-1" && "b";
+    builder["choice"] || "near" || "far";
+
+    PatternMatcher matcher = builder.Finalize();
+
+    std::string input = "aaabbbb";
+    MemoPolicy policy  = GENERATE(MemoPolicy::All, MemoPolicy::Adaptive);
+
+    size_t found = 0;
+    for (size_t depth = 1; depth < 12; depth++)
+    {
+        CAPTURE(depth);
+
+        matcher.SetMemoPolicy(MemoPolicy::None);
+        auto expected = matcher.Match("choice", input, depth);
+
+        matcher.SetMemoPolicy(policy);
+
+        auto memoized = matcher.Match("choice", input, depth);
+        REQUIRE(expected.has_value() == memoized.has_value());
+        found += expected.has_value();
+        if (expected)
+            RequireSameTree(*expected, *memoized);
+    }
+
+    // One level short of what "far" needs, while "near" fits
+    matcher.SetMemoPolicy(policy);
+    REQUIRE(!matcher.Match("choice", input, 7));
+    REQUIRE(matcher.Match("choice", input, 8));
+    REQUIRE(matcher.LastMemoCounters().myHits > 0);
+
+    REQUIRE(found > 0);
+}
@@ -0,0 +1,163 @@
+
+#include <catch2/catch_all.hpp>
+#include <ranges>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "catch_pattern_matcher/TreeEquality.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    using Iterator = std::ranges::iterator_t<std::string>;
+}  // namespace
+
+TEST_CASE("parse_tree::json", "[parse_tree]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = GENERATE(JsonSample, "[]", "  12  ", "[[[[[[]]]]]]");
+
+    ParseTree<Iterator> tree;
+
+    auto expected = matcher.Match("value", input);
+    REQUIRE(expected);
+    REQUIRE(matcher.Match("value", input, tree));
+
+    REQUIRE(tree.Size() == tree.Root().Get().mySize);
+    RequireSameTree<Iterator>(*expected, tree.Root());
+
+    matcher.SetMemoPolicy(MemoPolicy::All);
+    REQUIRE(matcher.Match("value", input, tree));
+    RequireSameTree<Iterator>(*expected, tree.Root());
+}
+
+TEST_CASE("parse_tree::failure", "[parse_tree]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = "[1, 2,";
+
+    ParseTree<Iterator> tree;
+
+    REQUIRE(!matcher.Match("value", input, tree));
+    REQUIRE(tree.Empty());
+}
+
+TEST_CASE("parse_tree::reuse", "[parse_tree]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string large = R"([{ "a": [1, 2, 3], "b": "text" }, { "a": [4, 5, 6], "b": "more text" }])";
+    std::string small = "[1]";
+
+    ParseTree<Iterator> tree;
+
+    REQUIRE(matcher.Match("value", large, tree));
+    size_t capacity = tree.Capacity();
+    const auto* storage = tree.Nodes().data();
+
+    REQUIRE(matcher.Match("value", small, tree));
+    REQUIRE(tree.Root() == small);
+    REQUIRE(tree.Capacity() == capacity);
+    REQUIRE(tree.Nodes().data() == storage);
+}
+
+TEST_CASE("parse_tree::search", "[parse_tree]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher bnfMatcher = PatternBuilder::Builtin::BNF();
+
+    std::string spec = R"(
+foo:
+        bar
+
+baz:
+        b? a* r+
+)";
+
+    ParseTree<Iterator> tree;
+    REQUIRE(bnfMatcher.Match("doc", spec, tree));
+    REQUIRE(tree.Root() == spec);
+
+    std::vector<std::string> identifiers;
+    for (auto declaration : tree.Root().SearchFor(bnfMatcher["decl"]))
+    {
+        auto identifier = declaration.Find(bnfMatcher["identifier"]);
+        REQUIRE(identifier);
+        identifiers.emplace_back(identifier->begin(), identifier->end());
+    }
+
+    REQUIRE(identifiers == std::vector<std::string>{"foo", "baz"});
+
+    std::vector<std::string> parts;
+    for (auto part : tree.Root().SearchFor(bnfMatcher["value-part"])) parts.emplace_back(part.begin(), part.end());
+
+    std::optional<Success<Iterator>> reference = bnfMatcher.Match("doc", spec);
+    REQUIRE(reference);
+
+    std::vector<std::string> referenceParts;
+    for (Success<Iterator>& part : reference->SearchFor(bnfMatcher["value-part"]))
+        referenceParts.emplace_back(part.myBegin, part.myEnd);
+
+    REQUIRE(!parts.empty());
+    REQUIRE(parts == referenceParts);
+
+    using SearchMode = ParseTree<Iterator>::SearchMode;
+
+    size_t topLevel = std::ranges::distance(tree.Root().SearchFor(bnfMatcher["line"], SearchMode::TopLevelOnly));
+    REQUIRE(topLevel == tree.Root().ChildCount());
+
+    size_t recursive = std::ranges::distance(tree.Root().SearchFor(bnfMatcher["whitespace-char"]));
+    size_t all       = std::ranges::distance(tree.Root().SearchFor(bnfMatcher["whitespace-char"], SearchMode::All));
+    REQUIRE(recursive == all);
+    REQUIRE(recursive > 0);
+}
+
+TEST_CASE("parse_tree::modes", "[parse_tree]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = "[[1, [2, [3]]], [], 4]";
+
+    ParseTree<Iterator> tree;
+    REQUIRE(matcher.Match("value", input, tree));
+
+    std::optional<Success<Iterator>> reference = matcher.Match("value", input);
+    REQUIRE(reference);
+
+    using SearchMode = ParseTree<Iterator>::SearchMode;
+    using Nodes      = decltype(tree.Root().SearchFor(matcher["array"]));
+
+    static_assert(std::ranges::forward_range<Nodes>);
+
+    for (SearchMode mode : {SearchMode::TopLevelOnly, SearchMode::Recursive, SearchMode::All})
+    {
+        std::vector<std::string> found;
+        for (auto node : tree.Root().SearchFor(matcher["array"], mode)) found.emplace_back(node.begin(), node.end());
+
+        std::vector<std::string> expected;
+        for (Success<Iterator>& match : reference->SearchFor(matcher["array"], mode))
+            expected.emplace_back(match.myBegin, match.myEnd);
+
+        REQUIRE(found == expected);
+    }
+
+    size_t index = 0;
+    for (auto child : tree.Root().Children())
+    {
+        REQUIRE(child.Index() == tree.Root()[static_cast<int>(index)].Index());
+        index++;
+    }
+
+    REQUIRE(index == reference->mySubMatches.size());
+}
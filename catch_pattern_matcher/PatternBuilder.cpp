@@ -69,6 +69,28 @@ TEST_CASE("builder::basic")
     REQUIRE(matcher.Match("all", "abc")->mySubMatches[2] == "c");
 }
 
+TEST_CASE("builder::same_key")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    REQUIRE(!builder.HasKey("word"));
+
+    builder["letter"].OneOf("ab");
+    builder["word"] && "letter";
+    REQUIRE(builder.HasKey("word"));
+
+    // Using a key again gives back its builder, which keeps adding to the same fragment
+    builder["word"] && "letter";
+    REQUIRE(&builder["word"] == &builder["word"]);
+
+    PatternMatcher matcher = builder.Finalize();
+
+    REQUIRE(*matcher.Match("word", "abc") == "ab");
+    REQUIRE(!matcher.Match("word", "a"));
+}
+
 TEST_CASE("builder::bnf")
 {
     using namespace std::string_view_literals;
@@ -268,3 +290,85 @@ bat:
 
     REQUIRE(*matcher.Match("bat", "bar") == "b");
 }
+
+TEST_CASE("builder::bnf_first_part")
+{
+    using namespace pattern_matcher;
+
+    // The first part of an option is read by its own meta rule, it used to be left out of the built sequence
+    PatternMatcher matcher = PatternBuilder::FromBNF(R"(
+pair:
+        "a" "b"
+
+pairs:
+        pair+ "."
+)");
+
+    REQUIRE(*matcher.Match("pair", "abc") == "ab");
+    REQUIRE(!matcher.Match("pair", "b"));
+
+    REQUIRE(*matcher.Match("pairs", "abab.") == "abab.");
+    REQUIRE(!matcher.Match("pairs", "."));
+}
+
+TEST_CASE("builder::bnf_underscore")
+{
+    using namespace pattern_matcher;
+
+    // Only a leading underscore makes a declaration transparent, one inside a name is just part of it
+    PatternMatcher matcher = PatternBuilder::FromBNF(R"(
+snake_case:
+        "x" other_rule
+
+other_rule:
+        "y"
+)");
+
+    std::string input = "xy";
+
+    auto result = matcher.Match("snake_case", input);
+    REQUIRE(result);
+    REQUIRE(*result == "xy");
+    REQUIRE(matcher["other_rule"]->IsCaptured());
+    REQUIRE(result->Find(matcher["other_rule"]));
+}
+
+TEST_CASE("builder::bnf_class")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = PatternBuilder::FromBNF(R"(
+identifier:
+        [a-zA-Z_] [a-zA-Z0-9_]*
+
+not-quote:
+        [^"\n]+
+
+escapes:
+        [\]\\\-]+
+)");
+
+    REQUIRE(matcher["class-[a-zA-Z_]"]->GetType() == Fragment::Type::CharClass);
+    REQUIRE(matcher["class-[a-zA-Z_]"]->GetClass().Count() == 53);
+    REQUIRE(matcher["class-[^\"\\n]"]->GetClass().Count() == 254);
+
+    REQUIRE(*matcher.Match("identifier", "snake_case2 rest") == "snake_case2");
+    REQUIRE(*matcher.Match("identifier", "_") == "_");
+    REQUIRE(!matcher.Match("identifier", "2fast"));
+
+    REQUIRE(*matcher.Match("not-quote", "ab\xff c\"d") == "ab\xff c");
+    REQUIRE(!matcher.Match("not-quote", "\"ab"));
+
+    REQUIRE(*matcher.Match("escapes", "]\\-a") == "]\\-");
+
+    // Reversed ranges are an error like any other malformed grammar, nothing is built
+    PatternMatcher reversed = PatternBuilder::FromBNF(R"(
+backwards:
+        [z-a]
+)");
+
+    REQUIRE(reversed["backwards"] == nullptr);
+
+    PatternMatcher single = PatternBuilder::FromBNF("single:\n        [a-a]\n");
+    REQUIRE(*single.Match("single", "ab") == "a");
+}
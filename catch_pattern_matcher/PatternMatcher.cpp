@@ -3,7 +3,12 @@
 #include "pattern_matcher/PatternMatcher.h"
 
 #include <catch2/catch_all.hpp>
+#include <deque>
+#include <span>
 #include <string>
+#include <vector>
+
+#include "catch_pattern_matcher/JSON.h"
 
 TEST_CASE("construct::basic", "")
 {
@@ -100,4 +105,38 @@ TEST_CASE("basic", "")
     REQUIRE(matcher.Match("all", "abc")->mySubMatches[0] == "a");
     REQUIRE(matcher.Match("all", "abc")->mySubMatches[1] == "b");
     REQUIRE(matcher.Match("all", "abc")->mySubMatches[2] == "c");
-}
\ No newline at end of file
+}
+
+TEST_CASE("matcher::contiguous", "[matcher]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = std::string(JsonSample) + " trailing";
+
+    // Contiguous inputs run on raw pointers, the deque runs on its own iterators
+    std::string_view view = input;
+    std::vector<char> vector(input.begin(), input.end());
+    std::span<const char> span = view;
+    std::deque<char> deque(input.begin(), input.end());
+
+    auto expected = matcher.Match("value", input);
+    REQUIRE(expected);
+
+    size_t length = expected->myEnd - input.begin();
+
+    REQUIRE(matcher.Match("value", view)->myEnd == view.begin() + length);
+    REQUIRE(matcher.Match("value", vector)->myEnd == vector.begin() + length);
+    REQUIRE(matcher.Match("value", span)->myEnd == span.begin() + length);
+    REQUIRE(matcher.Match("value", deque)->myEnd == deque.begin() + length);
+    REQUIRE(*matcher.Recognize("value", input.c_str()) == input.c_str() + length);
+
+    auto fromVector = matcher.Match("value", vector);
+    REQUIRE(fromVector->mySubMatches.size() == expected->mySubMatches.size());
+    REQUIRE((*fromVector)[1].myBegin - vector.begin() == (*expected)[1].myBegin - input.begin());
+
+    ParseTree<std::vector<char>::iterator> tree;
+    REQUIRE(matcher.Match("value", vector, tree));
+    REQUIRE(tree.Root().end() == vector.begin() + length);
+}
@@ -0,0 +1,157 @@
+#include <catch2/catch_all.hpp>
+#include <sstream>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "catch_pattern_matcher/TreeEquality.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+TEST_CASE("profile::json", "[profile]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = JsonSample;
+
+    MatchProfile profile;
+    auto result = matcher.Match("value", input, profile);
+    REQUIRE(result);
+    RequireSameTree(*matcher.Match("value", input), *result);
+
+    // "value" is recursive, nested entries count again
+    const FragmentCounters& root = profile.Counters().at(matcher["value"]);
+    REQUIRE(root.myEntries > 1);
+    REQUIRE(root.mySuccesses > 1);
+    REQUIRE(root.myBytesConsumed > input.size());
+
+    for (auto& [fragment, counters] : profile.Counters())
+    {
+        REQUIRE(counters.myEntries == counters.mySuccesses + counters.myFailures);
+        REQUIRE(counters.myExclusiveSteps <= counters.myInclusiveSteps + counters.myEntries);
+    }
+
+    auto sorted = profile.SortedByCost();
+    REQUIRE(sorted.size() == profile.Counters().size());
+    for (size_t i = 1; i < sorted.size(); i++)
+        REQUIRE(sorted[i - 1].second.myExclusiveSteps >= sorted[i].second.myExclusiveSteps);
+
+    // Counters add up over matches
+    size_t entries = root.myEntries;
+    REQUIRE(matcher.Recognize("value", input, profile) == input.end());
+    REQUIRE(profile.Counters().at(matcher["value"]).myEntries == entries * 2);
+
+    std::string report = matcher.ProfileReport(profile, 5);
+    REQUIRE(report.find("exclusive") != std::string::npos);
+    REQUIRE(report.find(matcher.NameOf(sorted[0].first)) != std::string::npos);
+    REQUIRE(std::count(report.begin(), report.end(), '\n') == 6);
+
+    profile.Clear();
+    REQUIRE(profile.Counters().empty());
+}
+
+TEST_CASE("profile::steps", "[profile]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = "  -12.5e3  ";
+
+    MatchProfile profile;
+    REQUIRE(matcher.Match("value", input, profile));
+
+    const FragmentCounters& root = profile.Counters().at(matcher["value"]);
+    REQUIRE(root.myEntries == 1);
+    REQUIRE(root.mySuccesses == 1);
+    REQUIRE(root.myBytesConsumed == input.size());
+
+    size_t exclusive = 0;
+    for (auto& [fragment, counters] : profile.Counters())
+    {
+        REQUIRE(counters.myInclusiveSteps <= root.myInclusiveSteps);
+        exclusive += counters.myExclusiveSteps;
+    }
+
+    // Without recursion every step is spent on exactly one fragment while the root is open
+    REQUIRE(exclusive == root.myInclusiveSteps + 1);
+}
+
+TEST_CASE("profile::backtracking", "[profile]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["a"] = "a";
+    builder["b"] = "b";
+    builder["x"] = "x";
+    builder["y"] = "y";
+
+    builder["abx"] && "a" && "b" && "x";
+    builder["aby"] && "a" && "b" && "y";
+    builder["either"] || "abx" || "aby";
+
+    PatternMatcher matcher = builder.Finalize();
+
+    MatchProfile profile;
+    REQUIRE(matcher.Match("either", "aby", profile));
+
+    // "abx" gets through "ab" before failing
+    REQUIRE(profile.Counters().at(matcher["abx"]).myFailures == 1);
+    REQUIRE(profile.Counters().at(matcher["abx"]).myBytesDiscarded == 2);
+    REQUIRE(profile.Counters().at(matcher["aby"]).mySuccesses == 1);
+    REQUIRE(profile.Counters().at(matcher["aby"]).myBytesConsumed == 3);
+
+    REQUIRE(matcher.ProfileReport(profile).find("abx") != std::string::npos);
+}
+
+TEST_CASE("profile::trace", "[profile]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = JsonSample;
+
+    MatchProfile profile;
+    REQUIRE(matcher.Match("value", input, profile));
+
+    size_t interval = GENERATE(1, 7);
+    CAPTURE(interval);
+
+    MatchTrace trace(interval);
+    auto result = matcher.Match("value", input, trace);
+    REQUIRE(result);
+    RequireSameTree(*matcher.Match("value", input), *result);
+
+    // Samples are weighted by the interval
+    size_t steps = 0;
+    for (auto& [fragment, counters] : profile.Counters()) steps += counters.myExclusiveSteps;
+
+    size_t total = 0;
+    for (auto& [stack, count] : trace.Samples())
+    {
+        REQUIRE(!stack.empty());
+        REQUIRE(stack.front() == matcher["value"]);
+        total += count;
+    }
+    REQUIRE(total == steps / interval * interval);
+
+    std::string collapsed = matcher.CollapsedStacks(trace);
+    REQUIRE(std::count(collapsed.begin(), collapsed.end(), '\n') == trace.Samples().size());
+
+    std::istringstream lines(collapsed);
+    for (std::string line; std::getline(lines, line);)
+    {
+        CAPTURE(line);
+
+        size_t space = line.rfind(' ');
+        REQUIRE(space != std::string::npos);
+        REQUIRE(line.starts_with("value"));
+        REQUIRE(std::stoul(line.substr(space + 1)) % interval == 0);
+    }
+
+    if (interval == 1)
+        REQUIRE(collapsed.find("value;whitespace ") != std::string::npos);
+}
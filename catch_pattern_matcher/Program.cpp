@@ -0,0 +1,74 @@
+
+#include <catch2/catch_all.hpp>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "catch_pattern_matcher/TreeEquality.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    template<class Key>
+    void RequireSameResult(pattern_matcher::PatternMatcher<Key>& aMatcher, const pattern_matcher::Program& aProgram,
+                           Key aRoot, const std::string& aInput)
+    {
+        auto expected = aMatcher.Match(aRoot, aInput);
+        auto actual   = aProgram.Match(std::ranges::begin(aInput), std::ranges::end(aInput));
+
+        CAPTURE(aInput);
+        REQUIRE(expected.has_value() == actual.has_value());
+
+        if (expected)
+            RequireSameTree(*expected, *actual);
+    }
+}  // namespace
+
+TEST_CASE("program::basic", "[program]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeAbcParser().Finalize();
+
+    for (std::string root : AbcRoots)
+    {
+        CAPTURE(root);
+        Program program = matcher.Compile(root);
+
+        for (std::string input : AbcInputs) RequireSameResult(matcher, program, root, input);
+    }
+}
+
+TEST_CASE("program::json", "[program]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+    Program program        = matcher.Compile("value");
+
+    std::string input = GENERATE(JsonSample, "[]", "[1, 2,]", "{\"a\" 1}", "\"unterminated", "  12  ",
+                                 "[[[[[[]]]]]]", "01");
+
+    RequireSameResult(matcher, program, std::string("value"), input);
+}
+
+TEST_CASE("program::bnf", "[program]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = PatternBuilder::Builtin::BNF();
+    Program program        = matcher.Compile("doc");
+
+    std::string spec = R"(
+# comment
+foo:
+        bar
+    
+bar:
+        b a r | "literal"
+
+baz:
+        b? a* r+
+)";
+
+    RequireSameResult(matcher, program, std::string("doc"), spec);
+}
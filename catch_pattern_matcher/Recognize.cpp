@@ -0,0 +1,44 @@
+#include <catch2/catch_all.hpp>
+#include <string>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+TEST_CASE("recognize::json", "[recognize]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    std::string input = GENERATE(JsonSample, "[]", "  12  ", "[[[[[[]]]]]]", "[1, 2", "{ \"a\" }", "", "nul");
+
+    auto expected = matcher.Match("value", input);
+    auto end      = matcher.Recognize("value", input);
+
+    REQUIRE(expected.has_value() == end.has_value());
+    if (expected)
+        REQUIRE(expected->myEnd == *end);
+}
+
+TEST_CASE("recognize::prefix", "[recognize]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["a"] = "a";
+    builder["b"] = "b";
+    builder["as"] = {"a", {1, RepeatCount::Unbounded}};
+    builder["root"] && "as" && "b";
+
+    PatternMatcher matcher = builder.Finalize();
+
+    std::string input = "aaabaa";
+
+    auto end = matcher.Recognize("root", input);
+    REQUIRE(end);
+    REQUIRE(*end - input.begin() == 4);
+
+    REQUIRE(!matcher.Recognize("root", "aaa"));
+    REQUIRE(!matcher.Recognize("root", "b"));
+}
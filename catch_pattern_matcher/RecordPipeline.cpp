@@ -0,0 +1,140 @@
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "pattern_matcher/PatternBuilder.h"
+#include "pattern_matcher/RecordPipeline.h"
+
+namespace
+{
+    std::vector<std::string> MakeRecords(size_t aCount)
+    {
+        std::vector<std::string> out;
+
+        for (size_t i = 0; i < aCount; i++)
+        {
+            std::string record = "{\"id\": " + std::to_string(i) + ", \"tags\": [";
+            for (size_t j = 0; j < i % 7; j++) record += "\"t" + std::to_string(j) + "\", ";
+            record += "null]}";
+
+            // Some records are broken, one is much longer than a batch
+            if (i % 11 == 5)
+                record.pop_back();
+            if (i == 40)
+                record = "[" + std::string(500, '1') + "]";
+
+            out.push_back(record);
+        }
+
+        return out;
+    }
+
+    std::string Join(const std::vector<std::string>& aRecords)
+    {
+        std::string out;
+        for (size_t i = 0; i < aRecords.size(); i++)
+        {
+            out += aRecords[i];
+            out += i % 13 == 0 ? "\n\n" : "\n";
+        }
+
+        return out;
+    }
+
+    void RequireRecords(pattern_matcher::RecordPipeline<std::string>& aPipeline,
+                        const pattern_matcher::CompiledGrammar<std::string>& aGrammar,
+                        const std::vector<std::string>& aRecords)
+    {
+        for (size_t i = 0; i < aRecords.size(); i++)
+        {
+            CAPTURE(i);
+
+            std::optional<pattern_matcher::Record> record = aPipeline.Next();
+            REQUIRE(record);
+            REQUIRE(record->myIndex == i);
+            REQUIRE(record->myText == aRecords[i]);
+
+            auto expected = aGrammar.Match("value", aRecords[i]);
+            REQUIRE(record->myMatch.has_value() == expected.has_value());
+            if (expected)
+                REQUIRE(record->myMatch->myEnd - record->myText.data() == expected->myEnd - aRecords[i].begin());
+        }
+
+        REQUIRE(!aPipeline.Next());
+        REQUIRE(!aPipeline.Next());
+    }
+}  // namespace
+
+TEST_CASE("pipeline::stream", "[pipeline]")
+{
+    using namespace pattern_matcher;
+
+    std::shared_ptr<const CompiledGrammar<std::string>> grammar = MakeJsonParser().Finalize().Freeze();
+
+    std::vector<std::string> records = MakeRecords(200);
+
+    PipelineOptions options;
+    options.myThreads    = GENERATE(1, 4);
+    options.myBatchSize  = 64;
+    options.myMaxBatches = 2;
+
+    std::istringstream input(Join(records));
+
+    RecordPipeline pipeline(grammar, "value", options);
+    pipeline.Start(input);
+
+    RequireRecords(pipeline, *grammar, records);
+}
+
+TEST_CASE("pipeline::file", "[pipeline]")
+{
+    using namespace pattern_matcher;
+
+    std::shared_ptr<const CompiledGrammar<std::string>> grammar = MakeJsonParser().Finalize().Freeze();
+
+    std::vector<std::string> records = MakeRecords(300);
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pattern_matcher_pipeline.ndjson";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << Join(records);
+    }
+
+    std::shared_ptr<const MappedFile> file = MappedFile::Open(path);
+    std::filesystem::remove(path);
+    REQUIRE(file);
+
+    PipelineOptions options;
+    options.myThreads    = 3;
+    options.myBatchSize  = 100;
+    options.myMaxBatches = 4;
+
+    RecordPipeline pipeline(grammar, "value", options);
+    pipeline.Start(file);
+
+    RequireRecords(pipeline, *grammar, records);
+}
+
+TEST_CASE("pipeline::abandoned", "[pipeline]")
+{
+    using namespace pattern_matcher;
+
+    std::shared_ptr<const CompiledGrammar<std::string>> grammar = MakeJsonParser().Finalize().Freeze();
+
+    std::istringstream input(Join(MakeRecords(1'000)));
+
+    PipelineOptions options;
+    options.myThreads    = 2;
+    options.myBatchSize  = 32;
+    options.myMaxBatches = 1;
+
+    // The reader is held back by the consumer and has to be stopped when the pipeline goes away
+    RecordPipeline pipeline(grammar, "value", options);
+    pipeline.Start(input);
+
+    REQUIRE(pipeline.Next());
+}
@@ -0,0 +1,132 @@
+#include <catch2/catch_all.hpp>
+#include <deque>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include "catch_pattern_matcher/JSON.h"
+#include "catch_pattern_matcher/TreeEquality.h"
+#include "pattern_matcher/PatternBuilder.h"
+
+namespace
+{
+    using Iterator = std::string::const_iterator;
+
+    // Tries every start position in turn, what FindAll has to agree with
+    std::vector<pattern_matcher::Success<Iterator>> Scan(pattern_matcher::PatternMatcher<std::string>& aMatcher,
+                                                         const std::string& aRoot, const std::string& aInput,
+                                                         pattern_matcher::SearchMode aMode)
+    {
+        std::vector<pattern_matcher::Success<Iterator>> out;
+
+        for (Iterator at = aInput.begin();;)
+        {
+            auto match = aMatcher.Match(aMatcher[aRoot], at, aInput.end());
+
+            if (match)
+            {
+                Iterator end = match->myEnd;
+                out.push_back(std::move(*match));
+
+                if (aMode == pattern_matcher::SearchMode::NonOverlapping && end != at)
+                {
+                    at = end;
+                    continue;
+                }
+            }
+
+            if (at == aInput.end())
+                break;
+
+            ++at;
+        }
+
+        return out;
+    }
+
+    void RequireSameMatches(pattern_matcher::PatternMatcher<std::string>& aMatcher, const std::string& aRoot,
+                            const std::string& aInput, pattern_matcher::SearchMode aMode)
+    {
+        std::vector<pattern_matcher::Success<Iterator>> expected = Scan(aMatcher, aRoot, aInput, aMode);
+
+        size_t index = 0;
+        for (pattern_matcher::Success<Iterator>&& match : aMatcher.FindAll(aRoot, aInput, aMode))
+        {
+            REQUIRE(index < expected.size());
+            RequireSameTree(expected[index], match);
+            index++;
+        }
+
+        REQUIRE(index == expected.size());
+    }
+}  // namespace
+
+TEST_CASE("search::json_in_log", "[search]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    const std::string log = R"(12:00:01 request {"id": 1, "tags": ["a", "b"]} took 3ms
+12:00:02 retry {"id": 2, "nested": {"deep": [1, {"x": null}]}}
+12:00:03 broken {"id": 3, "tags": [} and then {"ok": true}
+no json on this line at all)";
+
+    RequireSameMatches(matcher, "object", log, SearchMode::NonOverlapping);
+    RequireSameMatches(matcher, "object", log, SearchMode::All);
+    RequireSameMatches(matcher, "number", log, SearchMode::NonOverlapping);
+    RequireSameMatches(matcher, "string", log, SearchMode::All);
+
+    size_t objects = 0;
+    for (Success<Iterator>&& object : matcher.FindAll("object", log))
+    {
+        (void)object;
+        objects++;
+    }
+
+    // The nested objects are inside the outer ones and only found when overlapping
+    REQUIRE(objects == 3);
+
+    auto first = matcher.Search("object", log);
+    REQUIRE(first);
+    REQUIRE(*first == std::string_view(R"({"id": 1, "tags": ["a", "b"]})"));
+
+    const std::string none = "no braces here";
+    REQUIRE(!matcher.Search("object", none));
+}
+
+TEST_CASE("search::nullable", "[search]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    // Whitespace matches empty, so it is tried at every position including the end
+    const std::string input = "a  b\t\n c";
+
+    RequireSameMatches(matcher, "whitespace", input, SearchMode::NonOverlapping);
+    RequireSameMatches(matcher, "whitespace", input, SearchMode::All);
+
+    const std::string empty;
+    RequireSameMatches(matcher, "whitespace", empty, SearchMode::NonOverlapping);
+    RequireSameMatches(matcher, "object", empty, SearchMode::NonOverlapping);
+}
+
+TEST_CASE("search::deque", "[search]")
+{
+    using namespace pattern_matcher;
+
+    PatternMatcher matcher = MakeJsonParser().Finalize();
+
+    // Not contiguous, so start positions are found by testing each byte against the FIRST set
+    const std::string text = R"(x {"a": 1} y {"b": [2]} z)";
+    std::deque<char> input(text.begin(), text.end());
+
+    static_assert(std::ranges::input_range<decltype(matcher.FindAll("object", input))>);
+
+    std::vector<std::string> found;
+    for (Success<std::deque<char>::iterator>&& match : matcher.FindAll("object", input))
+        found.emplace_back(match.myBegin, match.myEnd);
+
+    REQUIRE(found == std::vector<std::string>{R"({"a": 1})", R"({"b": [2]})"});
+}
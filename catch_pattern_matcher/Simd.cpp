@@ -0,0 +1,114 @@
+#include <catch2/catch_all.hpp>
+#include <random>
+#include <string>
+
+#include "pattern_matcher/PatternBuilder.h"
+#include "pattern_matcher/Simd.h"
+
+TEST_CASE("simd::span_kernels", "[simd]")
+{
+    using namespace pattern_matcher;
+
+    std::mt19937 random(GENERATE(1u, 2u, 3u, 4u));
+
+    for (int round = 0; round < 64; round++)
+    {
+        CharClass members;
+        size_t density = random() % 256;
+        for (size_t i = 0; i < 256; i++)
+            if (random() % 256 < density)
+                members.Set(static_cast<unsigned char>(i));
+
+        // Mostly members so runs get long enough to cross vector boundaries
+        std::vector<unsigned char> input(random() % 200);
+        for (unsigned char& byte : input)
+        {
+            byte = static_cast<unsigned char>(random());
+            for (int tries = 0; tries < 8 && !members.Contains(byte); tries++) byte = static_cast<unsigned char>(random());
+        }
+
+        const unsigned char* begin = input.data();
+        const unsigned char* end   = input.data() + input.size();
+
+        size_t expected = simd::SpanOf(members, begin, end, simd::Kernel::Scalar);
+
+        for (simd::Kernel kernel : {simd::Kernel::Ssse3, simd::Kernel::Avx2})
+            if (simd::Supports(kernel))
+                REQUIRE(simd::SpanOf(members, begin, end, kernel) == expected);
+
+        REQUIRE(simd::SpanOf(members, begin, end) == expected);
+    }
+}
+
+TEST_CASE("simd::byte_finder", "[simd]")
+{
+    using namespace pattern_matcher;
+
+    std::mt19937 random(GENERATE(1u, 2u, 3u));
+
+    for (int round = 0; round < 64; round++)
+    {
+        // Covers the empty set, single bytes through memchr and sparse sets through SpanOf
+        CharClass members;
+        size_t count = round % 4 == 0 ? 0 : round % 4 == 1 ? 1 : random() % 8;
+        for (size_t i = 0; i < count; i++) members.Set(static_cast<unsigned char>(random()));
+
+        std::vector<unsigned char> input(random() % 300);
+        for (unsigned char& byte : input) byte = static_cast<unsigned char>(random());
+
+        const unsigned char* begin = input.data();
+        const unsigned char* end   = input.data() + input.size();
+
+        simd::ByteFinder finder(members);
+
+        for (const unsigned char* at = begin; at != end; at++)
+        {
+            const unsigned char* expected = at;
+            while (expected != end && !members.Contains(*expected)) expected++;
+
+            REQUIRE(finder(at, end) == expected);
+        }
+
+        REQUIRE(finder(end, end) == end);
+    }
+}
+
+TEST_CASE("simd::span_repeat", "[simd]")
+{
+    using namespace pattern_matcher;
+
+    PatternBuilder builder;
+
+    builder["space"].OneOf(" \t");
+    builder["spaces"]   = {"space", {0, RepeatCount::Unbounded}};
+    builder["two-four"] = {"space", {2, 4}};
+    builder["word"].NotOf(" ");
+    builder["words"] = {"word", {1, RepeatCount::Unbounded}};
+
+    PatternMatcher matcher = builder.Finalize();
+
+    REQUIRE(matcher["spaces"]->IsSpan());
+
+    std::string spaces(100, ' ');
+    spaces += "x";
+
+    auto result = matcher.Match("spaces", spaces);
+    REQUIRE(result);
+    REQUIRE(result->myEnd - spaces.begin() == 100);
+    REQUIRE(result->mySubMatches.size() == 100);
+    REQUIRE(result->mySubMatches[99].myFragment == matcher["space"]);
+
+    REQUIRE(*matcher.Match("spaces", "x") == "");
+
+    REQUIRE(!matcher.Match("two-four", " x"));
+    REQUIRE(*matcher.Match("two-four", "  x") == "  ");
+    REQUIRE(*matcher.Match("two-four", "\t \t \t ") == "\t \t ");
+
+    std::string text = "h\xc3\xa5llo w\xc3\xb6rld";
+    REQUIRE(*matcher.Match("words", text) == "h\xc3\xa5llo");
+
+    ParseTree<std::string::iterator> tree;
+    REQUIRE(matcher.Match("spaces", spaces, tree));
+    REQUIRE(tree.Size() == 101);
+    REQUIRE(tree.Root().ChildCount() == 100);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <catch2/catch_all.hpp>
+
+#include "pattern_matcher/ParseTree.h"
+#include "pattern_matcher/PatternMatchingTypes.h"
+
+template<class LeftIterator, class RightIterator>
+void RequireSameTree(const pattern_matcher::Success<LeftIterator>& aLeft,
+                     const pattern_matcher::Success<RightIterator>& aRight)
+{
+    REQUIRE(aLeft.myFragment == aRight.myFragment);
+    REQUIRE(aLeft.myBegin == aRight.myBegin);
+    REQUIRE(aLeft.myEnd == aRight.myEnd);
+    REQUIRE(aLeft.mySubMatches.size() == aRight.mySubMatches.size());
+
+    for (size_t i = 0; i < aLeft.mySubMatches.size(); i++) RequireSameTree(aLeft[i], aRight[i]);
+}
+
+template<class Iterator>
+void RequireSameTree(const pattern_matcher::Success<Iterator>& aSuccess,
+                     typename pattern_matcher::ParseTree<Iterator>::NodeRef aNode)
+{
+    REQUIRE(aSuccess.myFragment == aNode.GetFragment());
+    REQUIRE(aSuccess.myBegin == aNode.begin());
+    REQUIRE(aSuccess.myEnd == aNode.end());
+    REQUIRE(aSuccess.mySubMatches.size() == aNode.ChildCount());
+
+    for (size_t i = 0; i < aSuccess.mySubMatches.size(); i++) RequireSameTree<Iterator>(aSuccess[i], aNode[i]);
+}
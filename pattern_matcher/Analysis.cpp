@@ -0,0 +1,166 @@
+#include "pattern_matcher/Analysis.h"
+
+#include <algorithm>
+
+namespace pattern_matcher
+{
+    namespace
+    {
+        constexpr size_t Unbounded = RepeatCount::Unbounded;
+
+        // The least facts, what every fragment starts out with
+        struct Facts
+        {
+            CharClass myFirst;
+            bool myNullable    = false;
+            size_t myMinLength = Unbounded;
+            size_t myMaxLength = 0;
+
+            bool operator==(const Facts&) const = default;
+        };
+
+        size_t Add(size_t aLeft, size_t aRight)
+        {
+            if (aLeft == Unbounded || aRight == Unbounded || aLeft > Unbounded - aRight)
+                return Unbounded;
+
+            return aLeft + aRight;
+        }
+
+        size_t Multiply(size_t aLeft, size_t aRight)
+        {
+            if (aLeft == 0 || aRight == 0)
+                return 0;
+
+            if (aLeft == Unbounded || aRight == Unbounded || aLeft > Unbounded / aRight)
+                return Unbounded;
+
+            return aLeft * aRight;
+        }
+
+        Facts FactsOf(const Fragment* aFragment)
+        {
+            if (!aFragment->IsAnalyzed())
+                return Facts{CharClass::NotOf(""), true, 0, Unbounded};
+
+            return Facts{aFragment->First(), aFragment->IsNullable(), aFragment->MinLength(), aFragment->MaxLength()};
+        }
+
+        // One step of the fixpoint, computed from the current facts of the children
+        Facts Derive(const Fragment* aFragment)
+        {
+            Fragment::Children subFragments = aFragment->SubFragments();
+            Facts out;
+
+            switch (aFragment->GetType())
+            {
+                case Fragment::Type::Sequence: {
+                    bool leading   = true;
+                    out.myNullable  = true;
+                    out.myMinLength = 0;
+
+                    for (const Fragment* sub : subFragments)
+                    {
+                        Facts facts = FactsOf(sub);
+                        if (leading)
+                            out.myFirst |= facts.myFirst;
+                        leading &= facts.myNullable;
+
+                        out.myNullable &= facts.myNullable;
+                        out.myMinLength = Add(out.myMinLength, facts.myMinLength);
+                        out.myMaxLength = Add(out.myMaxLength, facts.myMaxLength);
+                    }
+                    break;
+                }
+
+                case Fragment::Type::Alternative:
+                    for (const Fragment* sub : subFragments)
+                    {
+                        Facts facts = FactsOf(sub);
+                        out.myFirst |= facts.myFirst;
+                        out.myNullable |= facts.myNullable;
+                        out.myMinLength = std::min(out.myMinLength, facts.myMinLength);
+                        out.myMaxLength = std::max(out.myMaxLength, facts.myMaxLength);
+                    }
+                    break;
+
+                case Fragment::Type::Repeat: {
+                    Facts facts       = FactsOf(subFragments[0]);
+                    RepeatCount count = aFragment->GetCount();
+
+                    if (count.myMax > 0)
+                        out.myFirst = facts.myFirst;
+                    out.myNullable  = count.myMin == 0 || facts.myNullable;
+                    out.myMinLength = Multiply(count.myMin, facts.myMinLength);
+                    out.myMaxLength = Multiply(count.myMax, facts.myMaxLength);
+                    break;
+                }
+
+                default:
+                    return FactsOf(aFragment);
+            }
+
+            return out;
+        }
+
+        bool IsComposite(const Fragment* aFragment)
+        {
+            switch (aFragment->GetType())
+            {
+                case Fragment::Type::Sequence:
+                case Fragment::Type::Alternative:
+                case Fragment::Type::Repeat:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }  // namespace
+
+    void Analyze(const std::vector<Fragment*>& aFragments)
+    {
+        // Start from nothing and grow until stable, which finds the least fixpoint even through recursive rules
+        for (Fragment* fragment : aFragments)
+        {
+            if (IsComposite(fragment))
+            {
+                Facts least;
+                fragment->SetAnalysis(least.myFirst, least.myNullable, least.myMinLength, least.myMaxLength);
+            }
+        }
+
+        // Lengths that still move after this many rounds are driven by a recursive rule and have no bound
+        size_t widenAfter = aFragments.size() + 1;
+
+        bool changed = true;
+        for (size_t round = 0; changed; round++)
+        {
+            changed = false;
+
+            for (Fragment* fragment : aFragments)
+            {
+                if (!IsComposite(fragment))
+                    continue;
+
+                Facts facts    = Derive(fragment);
+                Facts previous = FactsOf(fragment);
+
+                if (round >= widenAfter)
+                {
+                    if (facts.myMinLength != previous.myMinLength)
+                        facts.myMinLength = 0;
+                    if (facts.myMaxLength != previous.myMaxLength)
+                        facts.myMaxLength = Unbounded;
+                }
+
+                if (facts == previous)
+                    continue;
+
+                fragment->SetAnalysis(facts.myFirst, facts.myNullable, facts.myMinLength, facts.myMaxLength);
+                changed = true;
+            }
+        }
+
+        for (Fragment* fragment : aFragments) fragment->BuildCandidates();
+    }
+}  // namespace pattern_matcher
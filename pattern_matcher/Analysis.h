@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+
+#include "pattern_matcher/Fragment.h"
+
+namespace pattern_matcher
+{
+    // Computes the FIRST set, nullability and length bounds of every fragment in aFragments, then gives each
+    // alternative among them a table of the branches that can start with each byte. Children outside of aFragments
+    // that have not been analyzed are assumed to start with anything, to be nullable and to have no length bound.
+    void Analyze(const std::vector<Fragment*>& aFragments);
+}  // namespace pattern_matcher
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace pattern_matcher
+{
+    struct BatchOptions
+    {
+        // Workers matching at once including the calling thread, 0 uses one per hardware thread
+        size_t myThreads = 0;
+
+        // Inputs a worker claims at a time. Larger chunks mean less contention on the shared counter, smaller ones
+        // balance better when inputs vary a lot in size.
+        size_t myChunk = 16;
+
+        size_t myMaxDepth = 2'048;
+        size_t myMaxSteps = 4'294'967'296;
+    };
+
+    struct SplitOptions
+    {
+        // Threads matching at once including the calling thread, 0 uses one per hardware thread
+        size_t myThreads = 0;
+
+        // Inputs are not cut into chunks smaller than this, so small inputs are matched sequentially
+        size_t myMinChunkSize = 1 << 16;
+
+        size_t myMaxDepth = 2'048;
+        // Applies to the steps of every item used together, not those of chunks that were thrown away
+        size_t myMaxSteps = 4'294'967'296;
+    };
+
+    struct SplitCounters
+    {
+        size_t myChunks = 0;
+        // Chunks that started on an item boundary and were used as they were
+        size_t myAccepted = 0;
+        // Chunks that started inside an item or past the end of the match, their work was thrown away
+        size_t myRejected = 0;
+        // Items matched one at a time while stitching, between a rejected chunk and the next accepted one
+        size_t myFallbackItems = 0;
+    };
+
+    // The iterator of each input in a batch
+    template<class Inputs>
+    using BatchIterator = std::ranges::iterator_t<std::remove_reference_t<std::ranges::range_reference_t<Inputs>>>;
+
+    // Calls aWork(state, index) for every index below aCount spread over worker threads. Each worker makes its state
+    // once with aMakeState and keeps it for every index it handles. Workers claim chunks of indices from a shared
+    // counter, so one that finishes early takes over what is left instead of idling. The first exception thrown by a
+    // worker stops the others and is rethrown once every worker has joined.
+    template<class MakeState, class Work>
+    void ForEachParallel(size_t aCount, const BatchOptions& aOptions, MakeState&& aMakeState, Work&& aWork)
+    {
+        size_t chunk   = std::max<size_t>(aOptions.myChunk, 1);
+        size_t threads = aOptions.myThreads ? aOptions.myThreads : std::max(std::thread::hardware_concurrency(), 1u);
+        threads        = std::min(threads, (aCount + chunk - 1) / chunk);
+
+        if (threads == 0)
+            return;
+
+        std::atomic<size_t> next = 0;
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        auto worker = [&]() {
+            try
+            {
+                auto state = aMakeState();
+
+                for (size_t begin = next.fetch_add(chunk, std::memory_order_relaxed); begin < aCount;
+                     begin = next.fetch_add(chunk, std::memory_order_relaxed))
+                {
+                    size_t end = std::min(begin + chunk, aCount);
+                    for (size_t i = begin; i < end; i++) aWork(state, i);
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+
+                next = aCount;
+            }
+        };
+
+        {
+            std::vector<std::jthread> pool;
+            pool.reserve(threads - 1);
+
+            for (size_t i = 1; i < threads; i++) pool.emplace_back(worker);
+
+            worker();
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+}  // namespace pattern_matcher
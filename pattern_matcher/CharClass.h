@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace pattern_matcher
+{
+    // A set of bytes stored as a 256 bit bitset. The same set is also kept as two nibble tables for shuffle based
+    // vector lookups: entry l of LowRows() has bit h set when byte (h << 4 | l) is a member, HighRows() covers the
+    // bytes from 0x80 and up the same way.
+    class CharClass
+    {
+    public:
+        static constexpr size_t Size = 256;
+
+        static CharClass Of(std::string_view aChars)
+        {
+            CharClass out;
+            for (char c : aChars) out.Set(static_cast<unsigned char>(c));
+            return out;
+        }
+
+        static CharClass NotOf(std::string_view aChars)
+        {
+            CharClass out = Of(aChars);
+            out.Invert();
+            return out;
+        }
+
+        void Set(unsigned char aByte)
+        {
+            myWords[aByte >> 6] |= std::uint64_t(1) << (aByte & 63);
+
+            std::uint8_t row = static_cast<std::uint8_t>(1 << ((aByte >> 4) & 7));
+            if (aByte < 0x80)
+                myLowRows[aByte & 15] |= row;
+            else
+                myHighRows[aByte & 15] |= row;
+        }
+
+        void SetRange(unsigned char aFirst, unsigned char aLast)
+        {
+            for (size_t i = aFirst; i <= aLast; i++) Set(static_cast<unsigned char>(i));
+        }
+
+        void Invert()
+        {
+            for (std::uint64_t& word : myWords) word = ~word;
+            for (std::uint8_t& row : myLowRows) row = static_cast<std::uint8_t>(~row);
+            for (std::uint8_t& row : myHighRows) row = static_cast<std::uint8_t>(~row);
+        }
+
+        CharClass& operator|=(const CharClass& aOther)
+        {
+            for (size_t i = 0; i < Size / 64; i++) myWords[i] |= aOther.myWords[i];
+            for (size_t i = 0; i < 16; i++)
+            {
+                myLowRows[i] |= aOther.myLowRows[i];
+                myHighRows[i] |= aOther.myHighRows[i];
+            }
+            return *this;
+        }
+
+        bool Contains(unsigned char aByte) const { return (myWords[aByte >> 6] >> (aByte & 63)) & 1; }
+
+        size_t Count() const
+        {
+            size_t count = 0;
+            for (std::uint64_t word : myWords) count += std::popcount(word);
+            return count;
+        }
+
+        const std::array<std::uint8_t, 16>& LowRows() const { return myLowRows; }
+        const std::array<std::uint8_t, 16>& HighRows() const { return myHighRows; }
+
+        bool operator==(const CharClass&) const = default;
+
+    private:
+        std::uint64_t myWords[Size / 64] = {};
+        std::array<std::uint8_t, 16> myLowRows  = {};
+        std::array<std::uint8_t, 16> myHighRows = {};
+    };
+}  // namespace pattern_matcher
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pattern_matcher/PatternMatcher.h"
+
+namespace pattern_matcher
+{
+    // An immutable grammar, made by PatternMatcher::Freeze. Every entry point is const and keeps the state of a match
+    // on the caller's stack, so one grammar can be shared through a shared_ptr and matched on from many threads at
+    // once. Matching only runs on the packed fragments, which hold their own copies of the literals, and keys and
+    // literals are resolved through tables made when frozen so the shared literals of PatternMatcher are never read.
+    template<class Key = std::string>
+    class CompiledGrammar
+    {
+    public:
+        // Use PatternMatcher::Freeze, aMatcher has to be packed
+        CompiledGrammar(PatternMatcher<Key>&& aMatcher) : myMatcher(std::move(aMatcher))
+        {
+            assert(myMatcher.IsPacked());
+
+            for (auto& [key, fragment] : myMatcher.Fragments()) myRoots.emplace(key, myMatcher[key]);
+
+            for (size_t i = 0; i < PatternMatcherLiterals::size; i++)
+            {
+                const Fragment* literal = myMatcher[static_cast<Fragment::Literal>(i)];
+                myLiterals[i]           = myMatcher.Pool().Contains(literal) ? literal : nullptr;
+            }
+        }
+
+        CompiledGrammar(const CompiledGrammar&)            = delete;
+        CompiledGrammar& operator=(const CompiledGrammar&) = delete;
+
+        // nullptr when there is no such fragment
+        const Fragment* operator[](const Key& aKey) const
+        {
+            auto it = myRoots.find(aKey);
+            return it == myRoots.end() ? nullptr : it->second;
+        }
+
+        // nullptr when the grammar never uses the literal
+        const Fragment* operator[](Fragment::Literal aLiteral) const { return myLiterals[aLiteral]; }
+
+        const FragmentPool& Pool() const { return myMatcher.Pool(); }
+        MemoPolicy GetMemoPolicy() const { return myMatcher.GetMemoPolicy(); }
+
+        template<std::ranges::range Range>
+        std::optional<Success<std::ranges::iterator_t<Range>>> Match(const Key& aRoot, Range& aRange,
+                                                                     size_t aMaxDepth = 2'048,
+                                                                     size_t aMaxSteps = 4'294'967'296) const
+        {
+            return Match((*this)[aRoot], std::ranges::begin(aRange), std::ranges::end(aRange), aMaxDepth, aMaxSteps);
+        }
+
+        template<std::ranges::range Range>
+        std::optional<Success<std::ranges::iterator_t<Range>>> Match(const Fragment* aRoot, Range& aRange,
+                                                                     size_t aMaxDepth = 2'048,
+                                                                     size_t aMaxSteps = 4'294'967'296) const
+        {
+            return Match(aRoot, std::ranges::begin(aRange), std::ranges::end(aRange), aMaxDepth, aMaxSteps);
+        }
+
+        template<class Iterator, class Sentinel>
+        std::optional<Success<Iterator>> Match(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd,
+                                               size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296) const
+        {
+            auto [begin, end] = Lower(aBegin, aEnd);
+            TreeBuilder<Iterator, decltype(begin)> builder({aBegin, begin});
+
+            if (!Run(aRoot, begin, end, builder, aMaxDepth, aMaxSteps))
+                return {};
+
+            return builder.Result();
+        }
+
+        std::optional<Success<const char*>> Match(const Key& aRoot, const char* aRange, size_t aMaxDepth = 2'048,
+                                                  size_t aMaxSteps = 4'294'967'296) const
+        {
+            return Match((*this)[aRoot], aRange, aRange + ::strlen(aRange), aMaxDepth, aMaxSteps);
+        }
+
+        // Matches into a flat ParseTree, reusing the storage of aOut
+        template<std::ranges::random_access_range Range>
+        bool Match(const Key& aRoot, Range& aRange, ParseTree<std::ranges::iterator_t<Range>>& aOut,
+                   size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296) const
+        {
+            return Match((*this)[aRoot], std::ranges::begin(aRange), std::ranges::end(aRange), aOut, aMaxDepth,
+                         aMaxSteps);
+        }
+
+        template<std::random_access_iterator Iterator, class Sentinel>
+        bool Match(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd, ParseTree<Iterator>& aOut,
+                   size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296) const
+        {
+            auto [begin, end] = Lower(aBegin, aEnd);
+            FlatTreeBuilder<Iterator, decltype(begin)> builder(aOut, aBegin, begin);
+
+            if (Run(aRoot, begin, end, builder, aMaxDepth, aMaxSteps))
+                return true;
+
+            aOut.Clear();
+            return false;
+        }
+
+        template<std::ranges::range Range>
+        std::optional<std::ranges::iterator_t<Range>> Recognize(const Key& aRoot, Range& aRange,
+                                                                size_t aMaxDepth = 2'048,
+                                                                size_t aMaxSteps = 4'294'967'296) const
+        {
+            return Recognize((*this)[aRoot], std::ranges::begin(aRange), std::ranges::end(aRange), aMaxDepth,
+                             aMaxSteps);
+        }
+
+        template<std::ranges::range Range>
+        std::optional<std::ranges::iterator_t<Range>> Recognize(const Fragment* aRoot, Range& aRange,
+                                                                size_t aMaxDepth = 2'048,
+                                                                size_t aMaxSteps = 4'294'967'296) const
+        {
+            return Recognize(aRoot, std::ranges::begin(aRange), std::ranges::end(aRange), aMaxDepth, aMaxSteps);
+        }
+
+        template<class Iterator, class Sentinel>
+        std::optional<Iterator> Recognize(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd,
+                                          size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296) const
+        {
+            auto [begin, end] = Lower(aBegin, aEnd);
+            RecognizeBuilder<Iterator, decltype(begin)> builder({aBegin, begin});
+
+            if (!Run(aRoot, begin, end, builder, aMaxDepth, aMaxSteps))
+                return {};
+
+            return builder.Result();
+        }
+
+        std::optional<const char*> Recognize(const Key& aRoot, const char* aRange, size_t aMaxDepth = 2'048,
+                                             size_t aMaxSteps = 4'294'967'296) const
+        {
+            return Recognize((*this)[aRoot], aRange, aRange + ::strlen(aRange), aMaxDepth, aMaxSteps);
+        }
+
+        // See PatternMatcher::MatchFile
+        std::optional<FileMatch> MatchFile(const Key& aRoot, const std::filesystem::path& aPath,
+                                           size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296) const
+        {
+            return MatchFile((*this)[aRoot], aPath, aMaxDepth, aMaxSteps);
+        }
+
+        std::optional<FileMatch> MatchFile(const Fragment* aRoot, const std::filesystem::path& aPath,
+                                           size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296) const
+        {
+            std::shared_ptr<const MappedFile> file = MappedFile::Open(aPath);
+            if (!file)
+                return {};
+
+            std::optional<Success<const char*>> result = Match(aRoot, file->begin(), file->end(), aMaxDepth, aMaxSteps);
+            if (!result)
+                return {};
+
+            return FileMatch{std::move(file), std::move(*result)};
+        }
+
+        // See PatternMatcher::FindAll
+        template<std::ranges::range Range>
+        std::optional<Success<std::ranges::iterator_t<Range>>> Search(const Key& aRoot, Range& aRange,
+                                                                      size_t aMaxDepth = 2'048,
+                                                                      size_t aMaxSteps = 4'294'967'296) const
+        {
+            return myMatcher.Search((*this)[aRoot], std::ranges::begin(aRange), std::ranges::end(aRange), aMaxDepth,
+                                    aMaxSteps);
+        }
+
+        template<std::ranges::range Range>
+        typename PatternMatcher<Key>::template Matches<std::ranges::iterator_t<Range>, std::ranges::sentinel_t<Range>>
+        FindAll(const Key& aRoot, Range& aRange, SearchMode aMode = SearchMode::NonOverlapping,
+                size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296) const
+        {
+            return myMatcher.FindAll((*this)[aRoot], std::ranges::begin(aRange), std::ranges::end(aRange), aMode,
+                                     aMaxDepth, aMaxSteps);
+        }
+
+        // See PatternMatcher::MatchMany
+        template<std::ranges::random_access_range Inputs>
+        std::vector<std::optional<Success<BatchIterator<Inputs>>>> MatchMany(const Key& aRoot, Inputs& aInputs,
+                                                                             const BatchOptions& aOptions = {}) const
+        {
+            return myMatcher.MatchMany((*this)[aRoot], aInputs, aOptions);
+        }
+
+        template<std::ranges::random_access_range Inputs>
+        std::vector<std::optional<Success<BatchIterator<Inputs>>>> MatchMany(const Fragment* aRoot, Inputs& aInputs,
+                                                                             const BatchOptions& aOptions = {}) const
+        {
+            return myMatcher.MatchMany(aRoot, aInputs, aOptions);
+        }
+
+        template<std::ranges::random_access_range Inputs>
+        std::vector<std::optional<BatchIterator<Inputs>>> RecognizeMany(const Key& aRoot, Inputs& aInputs,
+                                                                        const BatchOptions& aOptions = {}) const
+        {
+            return myMatcher.RecognizeMany((*this)[aRoot], aInputs, aOptions);
+        }
+
+        template<std::ranges::random_access_range Inputs>
+        std::vector<std::optional<BatchIterator<Inputs>>> RecognizeMany(const Fragment* aRoot, Inputs& aInputs,
+                                                                        const BatchOptions& aOptions = {}) const
+        {
+            return myMatcher.RecognizeMany(aRoot, aInputs, aOptions);
+        }
+
+        // See PatternMatcher::MatchParallel
+        template<std::ranges::random_access_range Range>
+        std::optional<Success<std::ranges::iterator_t<Range>>> MatchParallel(const Key& aRoot, const Key& aSync,
+                                                                             Range& aRange,
+                                                                             const SplitOptions& aOptions = {},
+                                                                             SplitCounters* aCounters = nullptr) const
+        {
+            return myMatcher.MatchParallel((*this)[aRoot], (*this)[aSync], std::ranges::begin(aRange),
+                                           std::ranges::end(aRange), aOptions, aCounters);
+        }
+
+    private:
+        template<class Iterator, class Sentinel, class Builder>
+        bool Run(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd, Builder& aBuilder, size_t aMaxDepth,
+                 size_t aMaxSteps) const
+        {
+            std::vector<MatchContext<Iterator>> contexts;
+            MemoCounters counters;
+            return myMatcher.Run(aRoot, aBegin, aEnd, aBuilder, aMaxDepth, aMaxSteps, contexts, counters);
+        }
+
+        PatternMatcher<Key> myMatcher;
+        std::unordered_map<Key, const Fragment*> myRoots;
+        std::array<const Fragment*, PatternMatcherLiterals::size> myLiterals;
+    };
+}  // namespace pattern_matcher
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <expected>
 #include <format>
 #include <memory>
@@ -14,9 +17,11 @@
 #include <variant>
 #include <vector>
 
+#include "pattern_matcher/CharClass.h"
 #include "pattern_matcher/Concepts.h"
 #include "pattern_matcher/PatternMatchingTypes.h"
 #include "pattern_matcher/RepeatCount.h"
+#include "pattern_matcher/Simd.h"
 namespace pattern_matcher
 {
     class Fragment
@@ -27,45 +32,91 @@ namespace pattern_matcher
         static constexpr SmallIndex NoIndex = std::numeric_limits<SmallIndex>::max();
         static_assert(sizeof(Literal) == sizeof(std::byte));
 
-        enum class Type
+        // Alternatives with more branches than this are not given a candidate table
+        static constexpr size_t MaxPredictedBranches = 64;
+
+        enum class Type : std::uint8_t
         {
             None,
             Literal,
+            String,
+            CharClass,
             Repeat,
             Sequence,
             Alternative
         };
 
-        Fragment() : myType(Type::None), myLiteral(0) {}
-        Fragment(const Literal& aLiteral) : myType(Type::Literal), myLiteral(aLiteral) {}
+        Fragment() : myType(Type::None), myAnalyzed(true), myLiteral(0) {}
+        Fragment(const Literal& aLiteral)
+            : myType(Type::Literal), myAnalyzed(true), myLiteral(aLiteral), myMinLength(1), myMaxLength(1)
+        {
+        }
+        Fragment(std::string aString)
+            : myType(Type::String)
+            , myAnalyzed(true)
+            , myStringSize(aString.size())
+            , myMinLength(aString.size())
+            , myMaxLength(aString.size())
+            , myStorage(StorageRef::Owned())
+            , myDataAt(0)
+        {
+            if (aString.empty())
+                myNullable = true;
+            else
+                myStorage->myClasses[myFirstAt].Set(static_cast<Literal>(aString[0]));
+
+            myStorage->myBytes = std::move(aString);
+        }
+        Fragment(const CharClass& aClass)
+            : myType(Type::CharClass)
+            , myAnalyzed(true)
+            , myLiteral(0)
+            , myMinLength(1)
+            , myMaxLength(1)
+            , myStorage(StorageRef::Owned())
+        {
+            myStorage->myClasses[myFirstAt] = aClass;
+            myDataAt                        = static_cast<std::uint32_t>(myStorage->myClasses.size());
+            myStorage->myClasses.push_back(aClass);
+        }
         Fragment(const Fragment* aSubPattern, RepeatCount aCount)
-            : myType(Type::Repeat), mySubFragments({aSubPattern}), myCount(aCount)
+            : myType(Type::Repeat), myChildCount(1), myCount(aCount), myStorage(StorageRef::Owned())
         {
+            myStorage->mySubFragments = {aSubPattern};
         }
-        Fragment(Type aType, const std::vector<const Fragment*> aFragments) : myType(aType), mySubFragments(aFragments)
+        Fragment(Type aType, const std::vector<const Fragment*> aFragments)
+            : myType(aType)
+            , myChildCount(static_cast<std::uint32_t>(aFragments.size()))
+            , myLUTPortion(0)
+            , myStorage(StorageRef::Owned())
         {
             assert(aType == Type::Sequence || aType == Type::Alternative);
             for (const Fragment* frag : aFragments) assert(frag);
 
+            myStorage->mySubFragments = aFragments;
+
             if (myType == Type::Alternative)
             {
-                for (SmallIndex& fragment : myLUT)
-                {
-                    fragment = NoIndex;
-                }
+                LookupTable table;
+                table.fill(NoIndex);
 
-                myLUTPortion = 0;
-                for (SmallIndex i = 0; i < mySubFragments.size(); i++)
+                for (SmallIndex i = 0; i < aFragments.size(); i++)
                 {
                     if (i == NoIndex)
                         break;
 
-                    if (mySubFragments[i]->myType != Type::Literal)
+                    if (aFragments[i]->myType != Type::Literal)
                         break;
 
-                    myLUT[(int)mySubFragments[i]->myLiteral] = i;
+                    table[aFragments[i]->myLiteral] = i;
                     myLUTPortion++;
                 }
+
+                if (myLUTPortion > 0)
+                {
+                    myDataAt = 0;
+                    myStorage->myTables.push_back(table);
+                }
             }
         }
 
@@ -77,25 +128,191 @@ namespace pattern_matcher
 
         ~Fragment() = default;
 
+        // The children of a fragment, held as pointers while it is being built and as 32 bit indices into the shared
+        // child array of a FragmentPool once packed
+        class Children
+        {
+        public:
+            class Iterator
+            {
+            public:
+                using value_type      = const Fragment*;
+                using difference_type = std::ptrdiff_t;
+
+                Iterator() = default;
+                Iterator(const Fragment* aParent, size_t aIndex) : myParent(aParent), myIndex(aIndex) {}
+
+                const Fragment* operator*() const { return myParent->Child(myIndex); }
+                Iterator& operator++()
+                {
+                    myIndex++;
+                    return *this;
+                }
+                Iterator operator++(int)
+                {
+                    Iterator out = *this;
+                    myIndex++;
+                    return out;
+                }
+
+                bool operator==(const Iterator&) const = default;
+
+            private:
+                const Fragment* myParent = nullptr;
+                size_t myIndex           = 0;
+            };
+
+            Children(const Fragment* aParent) : myParent(aParent) {}
+
+            size_t size() const { return myParent->myChildCount; }
+            bool empty() const { return myParent->myChildCount == 0; }
+            const Fragment* operator[](size_t aIndex) const { return myParent->Child(aIndex); }
+
+            Iterator begin() const { return Iterator(myParent, 0); }
+            Iterator end() const { return Iterator(myParent, myParent->myChildCount); }
+
+        private:
+            const Fragment* myParent;
+        };
+
         Type GetType() const { return myType; }
-        const std::vector<const Fragment*>& SubFragments() const { return mySubFragments; }
+        Children SubFragments() const { return Children(this); }
+
+        const Fragment* Child(size_t aIndex) const
+        {
+            if (myStorage.IsOwned())
+                return myStorage->mySubFragments[aIndex];
+
+            return myStorage->myFragments + myStorage->myChildren[myChildrenAt + aIndex];
+        }
+
+        // Whether the fragment lives in a FragmentPool
+        bool IsPacked() const { return myStorage.IsShared(); }
+
+        Literal GetLiteral() const { return myLiteral; }
+        std::string_view GetString() const { return {myStorage->myBytes.data() + myDataAt, myStringSize}; }
+        const CharClass& GetClass() const { return myStorage->myClasses[myDataAt]; }
+        RepeatCount GetCount() const { return myCount; }
+
+        // The leading run of literal children of an alternative is dispatched through a lookup table
+        size_t LookupPortion() const { return myType == Type::Alternative ? myLUTPortion : 0; }
+        SmallIndex LookupIndex(Literal aLiteral) const
+        {
+            return LookupPortion() > 0 ? myStorage->myTables[myDataAt][aLiteral] : NoIndex;
+        }
+
+        // The bytes a match can start with and whether it can match without consuming anything. Leaves know this from
+        // the start, the rest are filled in by Analyze, see Analysis.h. A fragment that has not been analyzed is
+        // assumed to be able to start with anything.
+        bool IsAnalyzed() const { return myAnalyzed; }
+        const CharClass& First() const
+        {
+            switch (myType)
+            {
+                case Type::None:
+                    return NoClass();
+                case Type::Literal:
+                    return LiteralClass(myLiteral);
+                default:
+                    return myStorage->myClasses[myFirstAt];
+            }
+        }
+        bool IsNullable() const { return myNullable; }
+
+        // Bounds on how much a successful match consumes, RepeatCount::Unbounded when there is no upper bound
+        size_t MinLength() const { return myMinLength; }
+        size_t MaxLength() const { return myMaxLength; }
+
+        void SetAnalysis(const CharClass& aFirst, bool aNullable, size_t aMinLength, size_t aMaxLength)
+        {
+            myStorage->myClasses[myFirstAt] = aFirst;
+
+            myNullable  = aNullable;
+            myAnalyzed  = true;
+            myMinLength = aMinLength;
+            myMaxLength = aMaxLength;
+        }
+
+        // Whether the branch at aIndex of an alternative is worth entering at a byte, or at the end of the input when
+        // aByte is empty
+        bool IsCandidate(size_t aIndex, std::optional<Literal> aByte) const
+        {
+            if (myCandidatesAt == NoData)
+                return true;
+
+            return (CandidateRow(aByte ? *aByte : EndRow) >> aIndex) & 1;
+        }
+
+        // Builds the byte indexed table of branches an alternative can take, from the analysis of its children
+        void BuildCandidates()
+        {
+            if (myType != Type::Alternative || myChildCount > MaxPredictedBranches)
+            {
+                myCandidatesAt = NoData;
+                return;
+            }
+
+            std::array<std::uint64_t, EndRow + 1> rows{};
+
+            for (size_t i = 0; i < myChildCount; i++)
+            {
+                const Fragment* sub = Child(i);
+                std::uint64_t bit   = std::uint64_t(1) << i;
+
+                if (!sub->myAnalyzed || sub->myNullable)
+                {
+                    for (std::uint64_t& row : rows) row |= bit;
+                    continue;
+                }
+
+                for (size_t b = 0; b < EndRow; b++)
+                    if (sub->First().Contains(static_cast<Literal>(b)))
+                        rows[b] |= bit;
+            }
+
+            // Built again in place when the fragment is analyzed again
+            std::vector<std::uint8_t>& candidates = myStorage->myCandidates;
+            if (myCandidatesAt == NoData)
+            {
+                myCandidatesAt = static_cast<std::uint32_t>(candidates.size());
+                candidates.resize(candidates.size() + rows.size() * CandidateWidth());
+            }
+
+            for (size_t b = 0; b < rows.size(); b++) StoreCandidateRow(b, rows[b]);
+        }
+
+        // Used by MemoPolicy::Flagged
+        void SetMemoize(bool aMemoize) { myMemoize = aMemoize; }
+        bool IsMemoized() const { return myMemoize; }
+
+        // Fragments that are not captured produce no node of their own, their captured children are given to the
+        // parent instead. The root of a match is always captured.
+        void SetCapture(bool aCapture) { myCapture = aCapture; }
+        bool IsCaptured() const { return myCapture; }
+
+        // A repeat over a character class matches its whole run in a single step without pushing its children, the
+        // matcher adds their nodes through Builder::Span
+        bool IsSpan() const { return myType == Type::Repeat && Child(0)->myType == Type::CharClass; }
 
         template<class Iterator>
         MatchContext<Iterator> BeginMatch(Iterator aBegin) const
         {
             MatchContext<Iterator> ctx;
 
-            ctx.myFragment = this;
-            ctx.myBegin    = aBegin;
-            ctx.myAt       = aBegin;
-            ctx.myIndex    = 0;
+            ctx.myFragment  = this;
+            ctx.myBegin     = aBegin;
+            ctx.myAt        = aBegin;
+            ctx.myIndex     = 0;
+            ctx.myUnchecked = false;
+            ctx.myTruncated = false;
+            ctx.myHeight    = 1;
 
             return ctx;
         }
 
         template<class Iterator, class Sentinel>
             requires std::equality_comparable_with<std::iter_value_t<Iterator>, Literal>
-                  && std::equality_comparable_with<Iterator, Sentinel>
+                  && std::sentinel_for<Sentinel, Iterator>
         Result<Iterator> ResumeMatch(MatchContext<Iterator>& aContext, const Result<Iterator>& aResult,
                                      Sentinel aEnd) const
         {
@@ -103,12 +320,16 @@ namespace pattern_matcher
             {
                 case Type::Literal:
                     return LiteralMatch(aContext, aResult, aEnd);
+                case Type::String:
+                    return StringMatch(aContext, aEnd);
+                case Type::CharClass:
+                    return CharClassMatch(aContext, aEnd);
                 case Type::Sequence:
                     return SequenceMatch(aContext, aResult);
                 case Type::Alternative:
                     return AlternativeMatch(aContext, aResult, aEnd);
                 case Type::Repeat:
-                    return RepeatMatch(aContext, aResult);
+                    return RepeatMatch(aContext, aResult, aEnd);
 
                 case Type::None:
                     break;
@@ -123,15 +344,59 @@ namespace pattern_matcher
         Result<Iterator> LiteralMatch(MatchContext<Iterator>& aContext, const Result<Iterator>& aResult,
                                       Sentinel aEnd) const
         {
-            if (aContext.myAt == aEnd)
+            if (!aContext.myUnchecked && aContext.myAt == aEnd)
+                return MatchFailure{};
+
+            if (myLiteral == static_cast<Literal>(*aContext.myAt))
+                return Success<Iterator>{this, aContext.myAt, aContext.myAt + 1};
+
+            return MatchFailure{};
+        }
+
+        template<class Iterator, class Sentinel>
+        Result<Iterator> CharClassMatch(MatchContext<Iterator>& aContext, Sentinel aEnd) const
+        {
+            if (!aContext.myUnchecked && aContext.myAt == aEnd)
                 return MatchFailure{};
 
-            if (myLiteral == *aContext.myAt)
+            if (GetClass().Contains(static_cast<Literal>(*aContext.myAt)))
                 return Success<Iterator>{this, aContext.myAt, aContext.myAt + 1};
 
             return MatchFailure{};
         }
 
+        template<class Iterator, class Sentinel>
+        Result<Iterator> StringMatch(MatchContext<Iterator>& aContext, Sentinel aEnd) const
+        {
+            if constexpr (std::contiguous_iterator<Iterator> && std::sized_sentinel_for<Sentinel, Iterator>
+                          && sizeof(std::iter_value_t<Iterator>) == 1)
+            {
+                std::string_view string = GetString();
+
+                if (!aContext.myUnchecked && static_cast<size_t>(aEnd - aContext.myAt) < string.size())
+                    return MatchFailure{};
+
+                if (!simd::Equal(reinterpret_cast<const unsigned char*>(std::to_address(aContext.myAt)),
+                                 reinterpret_cast<const unsigned char*>(string.data()), string.size()))
+                    return MatchFailure{};
+
+                return Success<Iterator>{this, aContext.myAt, aContext.myAt + string.size()};
+            }
+            else
+            {
+                Iterator at = aContext.myAt;
+
+                for (char c : GetString())
+                {
+                    if ((!aContext.myUnchecked && at == aEnd) || static_cast<Literal>(*at) != static_cast<Literal>(c))
+                        return MatchFailure{};
+                    ++at;
+                }
+
+                return Success<Iterator>{this, aContext.myAt, at};
+            }
+        }
+
         template<class Iterator>
         Result<Iterator> SequenceMatch(MatchContext<Iterator>& aContext, const Result<Iterator>& aResult) const
         {
@@ -140,7 +405,6 @@ namespace pattern_matcher
                 case MatchResultType::Failure:
                     return MatchFailure{};
                 case MatchResultType::Success:
-                    aContext.mySubMatches.push_back(aResult.Success());
                     aContext.myAt = aResult.Success().myEnd;
                     break;
                 case MatchResultType::None:
@@ -152,10 +416,10 @@ namespace pattern_matcher
                     break;
             }
 
-            if (aContext.myIndex == mySubFragments.size())
-                return Success<Iterator>{this, aContext.myBegin, aContext.myAt, aContext.mySubMatches};
+            if (aContext.myIndex == myChildCount)
+                return Success<Iterator>{this, aContext.myBegin, aContext.myAt};
 
-            return mySubFragments[aContext.myIndex++]->BeginMatch(aContext.myAt);
+            return Child(aContext.myIndex++)->BeginMatch(aContext.myAt);
         }
 
         template<class Iterator, class Sentinel>
@@ -164,22 +428,21 @@ namespace pattern_matcher
         {
             if (aContext.myIndex == 0 && myLUTPortion > 0)
             {
+                aContext.myIndex += myLUTPortion;
+
                 if (aContext.myBegin != aEnd)
                 {
                     std::iter_value_t<Iterator> v = *aContext.myAt;
 
-                    SmallIndex index = myLUT[(Literal)v];
+                    SmallIndex index = myStorage->myTables[myDataAt][(Literal)v];
 
                     if (index != NoIndex)
                     {
-                        return Success<Iterator>{this,
-                                                 aContext.myAt,
-                                                 aContext.myAt + 1,
-                                                 {Success<Iterator>{mySubFragments[index], aContext.myAt, aContext.myAt + 1}}};
+                        // The literal is known to match, no other alternative is tried after it
+                        aContext.myIndex = static_cast<int>(myChildCount);
+                        return Child(index)->BeginMatch(aContext.myBegin);
                     }
                 }
-
-                aContext.myIndex += myLUTPortion;
             }
 
             switch (aResult.GetType())
@@ -188,8 +451,7 @@ namespace pattern_matcher
                 case MatchResultType::None:
                     break;
                 case MatchResultType::Success:
-                    return Success<Iterator>{
-                        this, aResult.Success().myBegin, aResult.Success().myEnd, {aResult.Success()}};
+                    return Success<Iterator>{this, aResult.Success().myBegin, aResult.Success().myEnd};
                 case MatchResultType::InProgress:
                 default:
                     assert(false);
@@ -197,25 +459,71 @@ namespace pattern_matcher
                     break;
             }
 
-            if (aContext.myIndex == mySubFragments.size())
+            if (aContext.myIndex == myChildCount)
                 return MatchFailure{};
 
-            return mySubFragments[aContext.myIndex++]->BeginMatch(aContext.myBegin);
+            if (myCandidatesAt != NoData)
+            {
+                size_t at         = aContext.myBegin == aEnd ? EndRow : static_cast<Literal>(*aContext.myBegin);
+                std::uint64_t row = CandidateRow(at) >> aContext.myIndex << aContext.myIndex;
+
+                if (row == 0)
+                    return MatchFailure{};
+
+                // With no candidates left after this branch the alternative is done with its input once it is entered
+                int index        = std::countr_zero(row);
+                aContext.myIndex = (row & (row - 1)) ? index + 1 : static_cast<int>(myChildCount);
+
+                return Child(index)->BeginMatch(aContext.myBegin);
+            }
+
+            return Child(aContext.myIndex++)->BeginMatch(aContext.myBegin);
         }
 
-        template<class Iterator>
-        Result<Iterator> RepeatMatch(MatchContext<Iterator>& aContext, const Result<Iterator>& aResult) const
+        template<class Iterator, class Sentinel>
+        Result<Iterator> SpanMatch(MatchContext<Iterator>& aContext, Sentinel aEnd) const
         {
+            const CharClass& members = Child(0)->GetClass();
+            size_t count             = 0;
+
+            if constexpr (std::contiguous_iterator<Iterator> && std::sized_sentinel_for<Sentinel, Iterator>
+                          && sizeof(std::iter_value_t<Iterator>) == 1)
+            {
+                const unsigned char* at = reinterpret_cast<const unsigned char*>(std::to_address(aContext.myAt));
+
+                count = simd::SpanOf(members, at, at + std::min<size_t>(aEnd - aContext.myAt, myCount.myMax));
+            }
+            else
+            {
+                for (Iterator at = aContext.myAt;
+                     count < myCount.myMax && at != aEnd && members.Contains(static_cast<Literal>(*at)); ++at)
+                    count++;
+            }
+
+            if (count < myCount.myMin)
+                return MatchFailure{};
+
+            aContext.myAt = aContext.myAt + count;
+
+            return Success<Iterator>{this, aContext.myBegin, aContext.myAt};
+        }
+
+        template<class Iterator, class Sentinel>
+        Result<Iterator> RepeatMatch(MatchContext<Iterator>& aContext, const Result<Iterator>& aResult,
+                                     Sentinel aEnd) const
+        {
+            if (IsSpan())
+                return SpanMatch(aContext, aEnd);
+
             switch (aResult.GetType())
             {
                 case MatchResultType::Failure:
 
                     if (aContext.myIndex > myCount.myMin)
-                        return Success<Iterator>{this, aContext.myBegin, aContext.myAt, aContext.mySubMatches};
+                        return Success<Iterator>{this, aContext.myBegin, aContext.myAt};
 
                     return MatchFailure{};
                 case MatchResultType::Success:
-                    aContext.mySubMatches.push_back(aResult.Success());
                     aContext.myAt = aResult.Success().myEnd;
                     break;
                 case MatchResultType::None:
@@ -228,23 +536,222 @@ namespace pattern_matcher
             }
 
             if (aContext.myIndex == myCount.myMax)
-                return Success<Iterator>{this, aContext.myBegin, aContext.myAt, aContext.mySubMatches};
+                return Success<Iterator>{this, aContext.myBegin, aContext.myAt};
 
             aContext.myIndex++;
 
-            return mySubFragments[0]->BeginMatch(aContext.myAt);
+            return Child(0)->BeginMatch(aContext.myAt);
         }
 
     private:
-        SmallIndex myLUT[1 << (sizeof(Literal) * CHAR_BIT)];
+        friend class FragmentPool;
+
+        static constexpr size_t EndRow = 1 << (sizeof(Literal) * CHAR_BIT);
+
+        static constexpr std::uint32_t NoData = std::numeric_limits<std::uint32_t>::max();
+
+        using LookupTable = std::array<SmallIndex, 1 << (sizeof(Literal) * CHAR_BIT)>;
+
+        // The parts of fragments that vary in size, addressed by 32 bit indices. A fragment that is being built has a
+        // storage of its own, packed fragments share the one of their pool.
+        struct Storage
+        {
+            // Only in the storage of a pool, where children are indices into myFragments
+            const Fragment* myFragments = nullptr;
+            std::vector<std::uint32_t> myChildren;
+
+            // Only in the storage of a single fragment
+            std::vector<const Fragment*> mySubFragments;
+
+            std::vector<CharClass> myClasses;
+            std::string myBytes;
+            std::vector<LookupTable> myTables;
+
+            // Rows of bits, bit i of a row is set when branch i of an alternative may match at that byte. A row is as
+            // wide as the alternative needs, see CandidateWidth.
+            std::vector<std::uint8_t> myCandidates;
+        };
+
+        // Owns the storage of a fragment that is being built, copying the fragment copies it. Literals and empty
+        // fragments have nothing of variable size and hold none, see First.
+        class StorageRef
+        {
+        public:
+            StorageRef() : myStorage(nullptr) {}
+            explicit StorageRef(Storage* aShared) : myStorage(aShared) {}
+
+            // A storage of its own, starting out holding the FIRST set of the fragment
+            static StorageRef Owned()
+            {
+                StorageRef out;
+                out.myOwned   = std::make_unique<Storage>();
+                out.myStorage = out.myOwned.get();
+                out.myOwned->myClasses.emplace_back();
+                return out;
+            }
+
+            StorageRef(const StorageRef& aOther)
+                : myOwned(aOther.myOwned ? std::make_unique<Storage>(*aOther.myOwned) : nullptr)
+                , myStorage(myOwned ? myOwned.get() : aOther.myStorage)
+            {
+            }
+            StorageRef& operator=(const StorageRef& aOther) { return *this = StorageRef(aOther); }
+
+            StorageRef(StorageRef&& aOther)
+                : myOwned(std::move(aOther.myOwned)), myStorage(std::exchange(aOther.myStorage, nullptr))
+            {
+            }
+            StorageRef& operator=(StorageRef&& aOther)
+            {
+                myOwned   = std::move(aOther.myOwned);
+                myStorage = std::exchange(aOther.myStorage, nullptr);
+                return *this;
+            }
+
+            bool IsOwned() const { return myOwned != nullptr; }
+            bool IsShared() const { return myStorage && !myOwned; }
+            Storage& operator*() const { return *myStorage; }
+            Storage* operator->() const { return myStorage; }
+
+        private:
+            std::unique_ptr<Storage> myOwned;
+            Storage* myStorage;
+        };
+
+        static const CharClass& NoClass()
+        {
+            static const CharClass none;
+            return none;
+        }
+
+        // Shared by every literal instead of each keeping a copy
+        static const CharClass& LiteralClass(Literal aLiteral)
+        {
+            static const std::array<CharClass, EndRow> classes = [] {
+                std::array<CharClass, EndRow> out;
+                for (size_t i = 0; i < EndRow; i++) out[i].Set(static_cast<Literal>(i));
+                return out;
+            }();
+            return classes[aLiteral];
+        }
+
+        // Bytes in a row of the candidate table, 1, 2, 4 or 8 for a bit per branch
+        size_t CandidateWidth() const { return std::bit_ceil((myChildCount + 7u) / 8u); }
+
+        std::uint64_t CandidateRow(size_t aRow) const
+        {
+            const std::uint8_t* at = myStorage->myCandidates.data() + myCandidatesAt + aRow * CandidateWidth();
+
+            switch (CandidateWidth())
+            {
+                case 1:
+                    return *at;
+                case 2:
+                    return Load<std::uint16_t>(at);
+                case 4:
+                    return Load<std::uint32_t>(at);
+                default:
+                    return Load<std::uint64_t>(at);
+            }
+        }
+
+        void StoreCandidateRow(size_t aRow, std::uint64_t aBits)
+        {
+            std::uint8_t* at = myStorage->myCandidates.data() + myCandidatesAt + aRow * CandidateWidth();
+
+            switch (CandidateWidth())
+            {
+                case 1:
+                    *at = static_cast<std::uint8_t>(aBits);
+                    break;
+                case 2:
+                    Store<std::uint16_t>(at, aBits);
+                    break;
+                case 4:
+                    Store<std::uint32_t>(at, aBits);
+                    break;
+                default:
+                    Store<std::uint64_t>(at, aBits);
+                    break;
+            }
+        }
+
+        // The rows are not aligned to their width
+        template<class Row>
+        static std::uint64_t Load(const std::uint8_t* aAt)
+        {
+            Row out;
+            std::memcpy(&out, aAt, sizeof(Row));
+            return out;
+        }
+
+        template<class Row>
+        static void Store(std::uint8_t* aAt, std::uint64_t aBits)
+        {
+            Row row = static_cast<Row>(aBits);
+            std::memcpy(aAt, &row, sizeof(Row));
+        }
+
+        // Copies what the fragment keeps in its storage into the storage of its pool, where its children start at
+        // aChildrenAt
+        void Pack(Storage& aPool, std::uint32_t aChildrenAt)
+        {
+            if (!myStorage.IsOwned())
+            {
+                myStorage = StorageRef(&aPool);
+                return;
+            }
+
+            const Storage& from = *myStorage;
+
+            auto append = [](auto& aTo, auto aBegin, auto aEnd) {
+                std::uint32_t at = static_cast<std::uint32_t>(aTo.size());
+                aTo.insert(aTo.end(), aBegin, aEnd);
+                return at;
+            };
+
+            myFirstAt = append(aPool.myClasses, from.myClasses.begin() + myFirstAt,
+                               from.myClasses.begin() + myFirstAt + 1);
+
+            if (myType == Type::CharClass)
+                myDataAt = append(aPool.myClasses, from.myClasses.begin() + myDataAt,
+                                  from.myClasses.begin() + myDataAt + 1);
+            else if (myType == Type::String)
+                myDataAt = append(aPool.myBytes, from.myBytes.begin() + myDataAt,
+                                  from.myBytes.begin() + myDataAt + myStringSize);
+            else if (LookupPortion() > 0)
+                myDataAt = append(aPool.myTables, from.myTables.begin() + myDataAt,
+                                  from.myTables.begin() + myDataAt + 1);
+
+            if (myCandidatesAt != NoData)
+                myCandidatesAt = append(aPool.myCandidates, from.myCandidates.begin() + myCandidatesAt,
+                                        from.myCandidates.begin() + myCandidatesAt + (EndRow + 1) * CandidateWidth());
+
+            myChildrenAt = aChildrenAt;
+            myStorage    = StorageRef(&aPool);
+        }
+
         Type myType;
+        bool myMemoize             = false;
+        bool myCapture             = true;
+        bool myNullable            = false;
+        bool myAnalyzed            = false;
+        std::uint32_t myChildCount = 0;
+        std::uint32_t myChildrenAt = 0;  // packed only
         union
         {
-            size_t myLUTPortion;    // type: Alternative
-            Literal myLiteral;      // type: Literal
-            RepeatCount myCount;    // type: Repeat
+            size_t myLUTPortion;  // type: Alternative
+            Literal myLiteral;    // type: Literal
+            RepeatCount myCount;  // type: Repeat
+            size_t myStringSize;  // type: String
         };
-        std::vector<const Fragment*> mySubFragments;
+        size_t myMinLength = 0;
+        size_t myMaxLength = RepeatCount::Unbounded;
+        StorageRef myStorage;
+        std::uint32_t myFirstAt      = 0;
+        std::uint32_t myDataAt       = NoData;  // the bytes of a String, the class of a CharClass or the lookup table
+                                                // of an Alternative
+        std::uint32_t myCandidatesAt = NoData;  // type: Alternative
     };
 
 }  // namespace pattern_matcher
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "pattern_matcher/FragmentPool.h"
+
+namespace pattern_matcher
+{
+    FragmentPool::FragmentPool(const std::vector<const Fragment*>& aRoots)
+    {
+        std::vector<const Fragment*> order;
+        std::vector<const Fragment*> stack(aRoots.rbegin(), aRoots.rend());
+        size_t children = 0;
+
+        while (!stack.empty())
+        {
+            const Fragment* fragment = stack.back();
+            stack.pop_back();
+
+            if (!fragment || !myIndices.emplace(fragment, static_cast<std::uint32_t>(order.size())).second)
+                continue;
+
+            order.push_back(fragment);
+
+            Fragment::Children subFragments = fragment->SubFragments();
+            children += subFragments.size();
+
+            // Pushed in reverse so the first child is placed right after its parent
+            for (size_t i = subFragments.size(); i-- > 0;) stack.push_back(subFragments[i]);
+        }
+
+        // Reserved up front, the packed fragments point into the array of fragments
+        myStorage = std::make_unique<Fragment::Storage>();
+        myFragments.reserve(order.size());
+        myStorage->myChildren.reserve(children);
+
+        for (const Fragment* original : order)
+        {
+            std::uint32_t first = static_cast<std::uint32_t>(myStorage->myChildren.size());
+
+            for (const Fragment* sub : original->SubFragments()) myStorage->myChildren.push_back(myIndices.at(sub));
+
+            myFragments.push_back(*original);
+            myFragments.back().Pack(*myStorage, first);
+        }
+
+        myStorage->myFragments = myFragments.data();
+    }
+
+    Fragment* FragmentPool::Find(const Fragment* aOriginal)
+    {
+        auto it = myIndices.find(aOriginal);
+        if (it == myIndices.end())
+            return nullptr;
+
+        return &myFragments[it->second];
+    }
+
+    const Fragment* FragmentPool::Find(const Fragment* aOriginal) const
+    {
+        return const_cast<FragmentPool*>(this)->Find(aOriginal);
+    }
+
+    std::vector<Fragment*> FragmentPool::Fragments()
+    {
+        std::vector<Fragment*> out;
+        out.reserve(myFragments.size());
+
+        for (Fragment& fragment : myFragments) out.push_back(&fragment);
+
+        return out;
+    }
+
+    size_t FragmentPool::Footprint() const
+    {
+        size_t out = myFragments.size() * sizeof(Fragment);
+
+        if (myStorage)
+        {
+            out += myStorage->myChildren.size() * sizeof(std::uint32_t);
+            out += myStorage->myClasses.size() * sizeof(CharClass);
+            out += myStorage->myBytes.size();
+            out += myStorage->myTables.size() * sizeof(Fragment::LookupTable);
+            out += myStorage->myCandidates.size();
+        }
+
+        return out;
+    }
+}  // namespace pattern_matcher
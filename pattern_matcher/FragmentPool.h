@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "pattern_matcher/Fragment.h"
+
+namespace pattern_matcher
+{
+    // A finalized copy of a fragment graph packed into one contiguous array, in depth first order from the roots so a
+    // rule sits next to the rules it starts with. Children are 32 bit indices into one shared array, and every literal
+    // the graph uses gets its own copy in the pool instead of pointing into the shared literals. Character classes,
+    // string bytes and the tables of alternatives are kept in shared side arrays too, which keeps the fragments small.
+    class FragmentPool
+    {
+    public:
+        FragmentPool() = default;
+        FragmentPool(const std::vector<const Fragment*>& aRoots);
+
+        FragmentPool(const FragmentPool&)            = delete;
+        FragmentPool& operator=(const FragmentPool&) = delete;
+
+        // The packed fragments stay where they are when the pool is moved
+        FragmentPool(FragmentPool&&)            = default;
+        FragmentPool& operator=(FragmentPool&&) = default;
+
+        bool Empty() const { return myFragments.empty(); }
+        size_t Size() const { return myFragments.size(); }
+
+        // The packed copy of aOriginal, nullptr when it was not reachable from the roots
+        Fragment* Find(const Fragment* aOriginal);
+        const Fragment* Find(const Fragment* aOriginal) const;
+
+        // Whether aFragment is one of the packed fragments
+        bool Contains(const Fragment* aFragment) const
+        {
+            return !myFragments.empty() && aFragment >= myFragments.data()
+                && aFragment < myFragments.data() + myFragments.size();
+        }
+
+        std::vector<Fragment*> Fragments();
+
+        // Bytes taken by the fragments and the side arrays
+        size_t Footprint() const;
+
+    private:
+        std::vector<Fragment> myFragments;
+        // Behind a pointer so the fragments can point at it and stay put when the pool is moved
+        std::unique_ptr<Fragment::Storage> myStorage;
+        std::unordered_map<const Fragment*, std::uint32_t> myIndices;
+    };
+}  // namespace pattern_matcher
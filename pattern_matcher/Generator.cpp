@@ -0,0 +1,460 @@
+#include "pattern_matcher/Generator.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace pattern_matcher
+{
+    InputGenerator::InputGenerator(const Fragment* aRoot, const GeneratorOptions& aOptions)
+        : myOptions(aOptions), myState(aOptions.mySeed)
+    {
+        std::vector<const Fragment*> fragments;
+        auto indexOf = [&](const Fragment* aFragment) {
+            auto [it, added] = myIndices.emplace(aFragment, static_cast<NodeIndex>(fragments.size()));
+            if (added)
+                fragments.push_back(aFragment);
+            return it->second;
+        };
+
+        indexOf(aRoot);
+
+        // Breadth first, fragments are indexed as they are found
+        for (size_t i = 0; i < fragments.size(); i++)
+        {
+            const Fragment* fragment = fragments[i];
+
+            Node node;
+            node.myType = fragment->GetType();
+
+            switch (node.myType)
+            {
+                case Fragment::Type::Literal:
+                    node.myBytes = std::string(1, static_cast<char>(fragment->GetLiteral()));
+                    break;
+                case Fragment::Type::String:
+                    node.myBytes = fragment->GetString();
+                    break;
+                case Fragment::Type::CharClass:
+                    for (int c = 0; c < 256; c++)
+                        if (fragment->GetClass().Contains(static_cast<unsigned char>(c)))
+                            node.myBytes += static_cast<char>(c);
+                    break;
+                case Fragment::Type::Repeat:
+                    node.myMin   = fragment->GetCount().myMin;
+                    node.myLimit = fragment->GetCount().myMax;
+                    node.myMax   = std::min(node.myLimit, node.myMin + myOptions.myMaxRepeat);
+                    [[fallthrough]];
+                case Fragment::Type::Sequence:
+                case Fragment::Type::Alternative:
+                    node.myFirstChild = static_cast<NodeIndex>(myChildren.size());
+                    node.myChildCount = static_cast<std::uint32_t>(fragment->SubFragments().size());
+
+                    for (const Fragment* child : fragment->SubFragments()) myChildren.push_back(indexOf(child));
+                    break;
+                case Fragment::Type::None:
+                    break;
+            }
+
+            myNodes.push_back(std::move(node));
+        }
+
+        FindShortest();
+        assert(myNodes[0].myShortestLength != NoLength);
+
+        // Branches and items that can't make an input are never taken
+        for (Node& node : myNodes)
+        {
+            if (node.myType == Fragment::Type::Repeat
+                && myNodes[myChildren[node.myFirstChild]].myShortestLength == NoLength)
+            {
+                node.myMax   = 0;
+                node.myLimit = 0;
+            }
+
+            if (node.myType != Fragment::Type::Alternative)
+                continue;
+
+            NodeIndex* begin = myChildren.data() + node.myFirstChild;
+            NodeIndex* end   = std::remove_if(begin, begin + node.myChildCount, [this](NodeIndex aChild) {
+                return myNodes[aChild].myShortestLength == NoLength;
+            });
+
+            node.myChildCount = static_cast<std::uint32_t>(end - begin);
+        }
+
+        std::array<bool, 256> used{};
+        for (const Node& node : myNodes)
+        {
+            if (node.myBytes.empty())
+                continue;
+
+            // All of a literal, only the ends of a class as a class may well be most of the bytes there are
+            if (node.myType == Fragment::Type::CharClass)
+            {
+                used[static_cast<unsigned char>(node.myBytes.front())] = true;
+                used[static_cast<unsigned char>(node.myBytes.back())]  = true;
+            }
+            else
+            {
+                for (char c : node.myBytes) used[static_cast<unsigned char>(c)] = true;
+            }
+        }
+
+        for (int c = 0; c < 256; c++)
+            if (used[c])
+                myAlphabet += static_cast<char>(c);
+
+        if (myAlphabet.empty())
+            myAlphabet = std::string(1, '\0');
+    }
+
+    void InputGenerator::Generate(std::string& aOut) { Emit(0, aOut); }
+
+    void InputGenerator::Generate(std::string& aOut, size_t aBytes, const Fragment* aFill)
+    {
+        auto it = myIndices.find(aFill);
+        if (it == myIndices.end() || myNodes[it->second].myType != Fragment::Type::Repeat)
+        {
+            Emit(0, aOut);
+            return;
+        }
+
+        myFill      = it->second;
+        myFilling   = true;
+        myFillBytes = aBytes;
+
+        // Until the fill is reached the walk steers towards it
+        myLeadsToFill.assign(myNodes.size(), false);
+        myLeadsToFill[myFill] = true;
+
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+
+            for (NodeIndex i = 0; i < myNodes.size(); i++)
+            {
+                if (myLeadsToFill[i])
+                    continue;
+
+                const NodeIndex* children = myChildren.data() + myNodes[i].myFirstChild;
+                for (size_t j = 0; j < myNodes[i].myChildCount; j++)
+                {
+                    if (myLeadsToFill[children[j]])
+                    {
+                        myLeadsToFill[i] = true;
+                        changed          = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        Emit(0, aOut);
+
+        myFilling = false;
+    }
+
+    void InputGenerator::GenerateRecords(std::string& aOut, size_t aBytes, std::string_view aSeparator)
+    {
+        // Gives up if nothing but empty inputs come out, they would never add up to aBytes
+        size_t empty = 0;
+        while (aOut.size() < aBytes && empty < 64)
+        {
+            size_t before = aOut.size();
+
+            Emit(0, aOut);
+            aOut += aSeparator;
+
+            empty = aOut.size() == before ? empty + 1 : 0;
+        }
+    }
+
+    void InputGenerator::Mutate(std::string& aInput)
+    {
+        size_t size = aInput.size();
+
+        if (size < 2)
+        {
+            aInput.insert(aInput.begin() + Below(size + 1), myAlphabet[Below(myAlphabet.size())]);
+            return;
+        }
+
+        size_t at = Below(size);
+
+        switch (Below(6))
+        {
+            case 0:
+                aInput.erase(at, 1);
+                break;
+            case 1:
+                aInput.insert(aInput.begin() + Below(size + 1), myAlphabet[Below(myAlphabet.size())]);
+                break;
+            case 2:
+                aInput[at] = myAlphabet[Below(myAlphabet.size())];
+                break;
+            case 3:
+                aInput.insert(at, aInput.substr(at, 1 + Below(std::min<size_t>(size - at, 8))));
+                break;
+            case 4:
+                aInput.resize(at);
+                break;
+            case 5:
+                at = std::min(at, size - 2);
+                std::swap(aInput[at], aInput[at + 1]);
+                break;
+        }
+    }
+
+    void InputGenerator::FindShortest()
+    {
+        auto add = [](size_t aLeft, size_t aRight) {
+            return aLeft == NoLength || aRight == NoLength ? NoLength : aLeft + aRight;
+        };
+
+        // Lengths only go down, so this settles once no node has found a shorter input
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+
+            for (Node& node : myNodes)
+            {
+                const NodeIndex* children = myChildren.data() + node.myFirstChild;
+
+                size_t length   = NoLength;
+                NodeIndex child = 0;
+
+                switch (node.myType)
+                {
+                    case Fragment::Type::Literal:
+                    case Fragment::Type::String:
+                        length = node.myBytes.size();
+                        break;
+                    case Fragment::Type::CharClass:
+                        length = node.myBytes.empty() ? NoLength : 1;
+                        break;
+                    case Fragment::Type::Repeat:
+                        if (node.myMin == 0)
+                            length = 0;
+                        else if (myNodes[children[0]].myShortestLength != NoLength)
+                            length = myNodes[children[0]].myShortestLength * node.myMin;
+                        break;
+                    case Fragment::Type::Sequence:
+                        length = 0;
+                        for (size_t i = 0; i < node.myChildCount; i++)
+                            length = add(length, myNodes[children[i]].myShortestLength);
+                        break;
+                    case Fragment::Type::Alternative:
+                        for (size_t i = 0; i < node.myChildCount; i++)
+                        {
+                            if (myNodes[children[i]].myShortestLength < length)
+                            {
+                                length = myNodes[children[i]].myShortestLength;
+                                child  = children[i];
+                            }
+                        }
+                        break;
+                    case Fragment::Type::None:
+                        break;
+                }
+
+                if (length < node.myShortestLength)
+                {
+                    node.myShortestLength = length;
+                    node.myShortestChild  = child;
+                    changed               = true;
+                }
+            }
+        }
+    }
+
+    const std::string& InputGenerator::Shortest(NodeIndex aNode)
+    {
+        if (myNodes[aNode].myHasShortest)
+            return myNodes[aNode].myShortest;
+
+        std::string out;
+        out.reserve(myNodes[aNode].myShortestLength);
+
+        const Node& node          = myNodes[aNode];
+        const NodeIndex* children = myChildren.data() + node.myFirstChild;
+
+        switch (node.myType)
+        {
+            case Fragment::Type::Literal:
+            case Fragment::Type::String:
+                out = node.myBytes;
+                break;
+            case Fragment::Type::CharClass:
+                out = node.myBytes.substr(0, 1);
+                break;
+            case Fragment::Type::Repeat:
+                for (size_t i = 0; i < node.myMin; i++) out += Shortest(children[0]);
+                break;
+            case Fragment::Type::Sequence:
+                for (size_t i = 0; i < node.myChildCount; i++) out += Shortest(children[i]);
+                break;
+            case Fragment::Type::Alternative:
+                out = Shortest(node.myShortestChild);
+                break;
+            case Fragment::Type::None:
+                break;
+        }
+
+        myNodes[aNode].myShortest    = std::move(out);
+        myNodes[aNode].myHasShortest = true;
+
+        return myNodes[aNode].myShortest;
+    }
+
+    void InputGenerator::Emit(NodeIndex aNode, std::string& aOut)
+    {
+        const Node& node = myNodes[aNode];
+
+        switch (node.myType)
+        {
+            case Fragment::Type::Literal:
+                aOut += node.myBytes[0];
+                break;
+            case Fragment::Type::String:
+                aOut += node.myBytes;
+                break;
+            case Fragment::Type::CharClass:
+                GenerateBytes(node, 1, aOut);
+                break;
+            case Fragment::Type::None:
+                break;
+            default:
+                Walk(aNode, aOut);
+                break;
+        }
+    }
+
+    void InputGenerator::Walk(NodeIndex aNode, std::string& aOut)
+    {
+        Node& node = myNodes[aNode];
+
+        if (node.myOpen >= myOptions.myMaxDepth)
+        {
+            aOut += Shortest(aNode);
+            return;
+        }
+
+        if (myFilling && myLeadsToFill[aNode])
+        {
+            WalkToFill(aNode, aOut);
+            return;
+        }
+
+        const NodeIndex* children = myChildren.data() + node.myFirstChild;
+
+        node.myOpen++;
+
+        switch (node.myType)
+        {
+            case Fragment::Type::Repeat: {
+                size_t count = node.myMin + Below(node.myMax - node.myMin + 1);
+
+                if (myNodes[children[0]].myType == Fragment::Type::CharClass)
+                    GenerateBytes(myNodes[children[0]], count, aOut);
+                else
+                    for (size_t i = 0; i < count; i++) Emit(children[0], aOut);
+            }
+            break;
+            case Fragment::Type::Sequence:
+                for (size_t i = 0; i < node.myChildCount; i++) Emit(children[i], aOut);
+                break;
+            case Fragment::Type::Alternative:
+                Emit(children[Below(node.myChildCount)], aOut);
+                break;
+            default:
+                break;
+        }
+
+        node.myOpen--;
+    }
+
+    void InputGenerator::WalkToFill(NodeIndex aNode, std::string& aOut)
+    {
+        Node& node                = myNodes[aNode];
+        const NodeIndex* children = myChildren.data() + node.myFirstChild;
+
+        node.myOpen++;
+
+        switch (node.myType)
+        {
+            case Fragment::Type::Repeat:
+                if (aNode == myFill)
+                {
+                    myFilling = false;
+
+                    for (size_t i = 0; i < node.myMin || (i < node.myLimit && aOut.size() < myFillBytes); i++)
+                        Emit(children[0], aOut);
+                }
+                else
+                {
+                    // At least one item, the fill is in there
+                    size_t count = node.myMin + Below(node.myMax - node.myMin + 1);
+                    for (size_t i = 0; i < std::max<size_t>(count, 1); i++) Emit(children[0], aOut);
+                }
+                break;
+            case Fragment::Type::Sequence:
+                for (size_t i = 0; i < node.myChildCount; i++) Emit(children[i], aOut);
+                break;
+            case Fragment::Type::Alternative: {
+                size_t leading = 0;
+                for (size_t i = 0; i < node.myChildCount; i++) leading += myLeadsToFill[children[i]];
+
+                size_t pick = Below(leading);
+                for (size_t i = 0; i < node.myChildCount; i++)
+                {
+                    if (myLeadsToFill[children[i]] && pick-- == 0)
+                    {
+                        Emit(children[i], aOut);
+                        break;
+                    }
+                }
+            }
+            break;
+            default:
+                break;
+        }
+
+        node.myOpen--;
+    }
+
+    void InputGenerator::GenerateBytes(const Node& aNode, size_t aCount, std::string& aOut)
+    {
+        const std::string& bytes = aNode.myBytes;
+        size_t size              = bytes.size();
+
+        if (size == 1)
+        {
+            aOut.append(aCount, bytes[0]);
+            return;
+        }
+
+        if (aCount == 1)
+        {
+            aOut += bytes[Below(size)];
+            return;
+        }
+
+        size_t at = aOut.size();
+        aOut.resize(at + aCount);
+        char* out = aOut.data() + at;
+
+        // Eight picks per random number, scaled rather than taken modulo the class size
+        while (aCount != 0)
+        {
+            std::uint64_t random = Next();
+            size_t picks         = std::min<size_t>(aCount, 8);
+
+            for (size_t i = 0; i < picks; i++, random >>= 8) *out++ = bytes[((random & 0xff) * size) >> 8];
+
+            aCount -= picks;
+        }
+    }
+}  // namespace pattern_matcher
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "pattern_matcher/Fragment.h"
+
+namespace pattern_matcher
+{
+    struct GeneratorOptions
+    {
+        // How many times a fragment may be open inside itself, deeper than this only the shortest input is made
+        size_t myMaxDepth = 8;
+
+        // Repeats make between their minimum and this many more items, fewer if their maximum is lower
+        size_t myMaxRepeat = 4;
+
+        std::uint64_t mySeed = 0;
+    };
+
+    // Makes random inputs by walking the fragments reachable from a root, for load tests and benchmarks. Ordered
+    // choice and greedy repeats are not taken into account, so an input is valid when the grammar does not depend
+    // on them, as most data formats don't, and can be checked with Recognize when it does. Mutate turns inputs into
+    // near misses.
+    class InputGenerator
+    {
+    public:
+        explicit InputGenerator(const Fragment* aRoot, const GeneratorOptions& aOptions = {});
+
+        // Appends one input to aOut
+        void Generate(std::string& aOut);
+
+        // Appends one input to aOut in which the outermost aFill, a repeat, keeps making items until aOut is at least
+        // aBytes long or the repeat is at its maximum. Everything else is as random as Generate makes it.
+        void Generate(std::string& aOut, size_t aBytes, const Fragment* aFill);
+
+        // Appends inputs ending in aSeparator to aOut until it is at least aBytes long, for record streams
+        void GenerateRecords(std::string& aOut, size_t aBytes, std::string_view aSeparator = "\n");
+
+        // Makes one small random edit to aInput: a byte removed, added, replaced or swapped, a few bytes repeated or
+        // the end cut off. Added bytes are taken from the grammar so the edit is a near miss rather than noise.
+        void Mutate(std::string& aInput);
+
+        // Mutates copies of aInput until aAccepts rejects one, which then replaces aInput. False if none of
+        // aAttempts copies was rejected, in which case aInput is left as it was.
+        template<class Accepts>
+        bool MutateInvalid(std::string& aInput, Accepts&& aAccepts, size_t aAttempts = 32)
+        {
+            std::string candidate;
+            for (size_t i = 0; i < aAttempts; i++)
+            {
+                candidate = aInput;
+                Mutate(candidate);
+
+                if (!aAccepts(std::as_const(candidate)))
+                {
+                    aInput = std::move(candidate);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+    private:
+        using NodeIndex = std::uint32_t;
+
+        static constexpr size_t NoLength = static_cast<size_t>(-1);
+
+        // The fragments are copied out into a flat array up front so generating doesn't chase fragment pointers
+        struct Node
+        {
+            Fragment::Type myType;
+            NodeIndex myFirstChild     = 0;
+            std::uint32_t myChildCount = 0;
+
+            // Items of a repeat, myMax is capped by GeneratorOptions::myMaxRepeat and myLimit is not
+            size_t myMin   = 0;
+            size_t myMax   = 0;
+            size_t myLimit = 0;
+
+            // The bytes of a literal or string, or the members of a char class
+            std::string myBytes;
+
+            // Length of the shortest input, NoLength when there is none, the branch an alternative takes for it and
+            // the input itself once asked for
+            size_t myShortestLength   = NoLength;
+            NodeIndex myShortestChild = 0;
+            bool myHasShortest        = false;
+            std::string myShortest;
+
+            // Times the node is open in the current input
+            size_t myOpen = 0;
+        };
+
+        void FindShortest();
+        const std::string& Shortest(NodeIndex aNode);
+
+        // Emit makes leaves itself and leaves the rest to Walk, WalkToFill is Walk steering towards myFill
+        void Emit(NodeIndex aNode, std::string& aOut);
+        void Walk(NodeIndex aNode, std::string& aOut);
+        void WalkToFill(NodeIndex aNode, std::string& aOut);
+        void GenerateBytes(const Node& aNode, size_t aCount, std::string& aOut);
+
+        std::uint64_t Next()
+        {
+            // splitmix64
+            std::uint64_t z = (myState += 0x9e3779b97f4a7c15);
+            z               = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z               = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            return z ^ (z >> 31);
+        }
+
+        // Half of a random number, the other half is kept for the next call
+        std::uint32_t NextHalf()
+        {
+            if (myHasHalf)
+            {
+                myHasHalf = false;
+                return myHalf;
+            }
+
+            std::uint64_t random = Next();
+            myHalf               = static_cast<std::uint32_t>(random >> 32);
+            myHasHalf            = true;
+            return static_cast<std::uint32_t>(random);
+        }
+
+        // Scaled rather than taken modulo aCount, which costs a division
+        size_t Below(size_t aCount)
+        {
+            if (aCount > 0xffff'ffff)
+                return static_cast<size_t>(Next() % aCount);
+
+            return static_cast<size_t>((static_cast<std::uint64_t>(NextHalf()) * aCount) >> 32);
+        }
+
+        GeneratorOptions myOptions;
+        std::uint64_t myState;
+        std::uint32_t myHalf = 0;
+        bool myHasHalf       = false;
+
+        std::vector<Node> myNodes;
+        std::vector<NodeIndex> myChildren;
+        std::unordered_map<const Fragment*, NodeIndex> myIndices;
+
+        // Bytes Mutate adds
+        std::string myAlphabet;
+
+        // The repeat Generate is growing, until it has been reached, and the nodes it can be reached through
+        NodeIndex myFill   = 0;
+        bool myFilling     = false;
+        size_t myFillBytes = 0;
+        std::vector<bool> myLeadsToFill;
+    };
+}  // namespace pattern_matcher
@@ -0,0 +1,571 @@
+#include "pattern_matcher/Jit.h"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__) && defined(__x86_64__)
+#define PATTERN_MATCHER_JIT 1
+#include <pthread.h>
+#include <sys/mman.h>
+#else
+#define PATTERN_MATCHER_JIT 0
+#endif
+
+namespace pattern_matcher
+{
+    namespace
+    {
+#if PATTERN_MATCHER_JIT
+
+        // Register usage of the generated code:
+        //   rbx: current position, advanced by successful matches, undefined after a failure
+        //   r12: end of input
+        //   r13: remaining depth
+        //   r14: lowest the stack pointer may go
+        // Fragment functions return al = 1 on success and al = 0 on failure
+        class Assembler
+        {
+        public:
+            using Label = size_t;
+
+            Label NewLabel()
+            {
+                myLabels.push_back(Unbound);
+                return myLabels.size() - 1;
+            }
+
+            void Bind(Label aLabel) { myLabels[aLabel] = myBytes.size(); }
+
+            size_t Size() const { return myBytes.size(); }
+
+            void Bytes(std::initializer_list<std::uint8_t> aBytes)
+            {
+                myBytes.insert(std::end(myBytes), std::begin(aBytes), std::end(aBytes));
+            }
+
+            void Immediate64(std::uint64_t aValue) { Immediate(aValue, 8); }
+            void Immediate32(std::uint32_t aValue) { Immediate(aValue, 4); }
+            void Immediate16(std::uint16_t aValue) { Immediate(aValue, 2); }
+
+            void Immediate(std::uint64_t aValue, int aBytes)
+            {
+                for (int i = 0; i < aBytes; i++) myBytes.push_back(static_cast<std::uint8_t>(aValue >> (i * 8)));
+            }
+
+            // Appends a 32 bit displacement relative to the end of itself
+            void Relative(Label aLabel)
+            {
+                myFixups.push_back({myBytes.size(), aLabel});
+                Bytes({0, 0, 0, 0});
+            }
+
+            void Jump(Label aLabel)
+            {
+                Bytes({0xE9});
+                Relative(aLabel);
+            }
+
+            void Call(Label aLabel)
+            {
+                Bytes({0xE8});
+                Relative(aLabel);
+            }
+
+            void JumpIf(std::uint8_t aCondition, Label aLabel)
+            {
+                Bytes({0x0F, aCondition});
+                Relative(aLabel);
+            }
+
+            static constexpr std::uint8_t Below        = 0x82;
+            static constexpr std::uint8_t AboveOrEqual = 0x83;
+            static constexpr std::uint8_t Equal        = 0x84;
+            static constexpr std::uint8_t NotEqual     = 0x85;
+
+            void Align(size_t aAlignment)
+            {
+                while (myBytes.size() % aAlignment != 0) myBytes.push_back(0xCC);
+            }
+
+            std::vector<std::uint8_t> Finish()
+            {
+                for (auto [at, label] : myFixups)
+                {
+                    assert(myLabels[label] != Unbound);
+
+                    std::int32_t displacement = static_cast<std::int32_t>(myLabels[label] - (at + 4));
+                    std::memcpy(myBytes.data() + at, &displacement, sizeof(displacement));
+                }
+
+                return std::move(myBytes);
+            }
+
+        private:
+            static constexpr size_t Unbound = std::numeric_limits<size_t>::max();
+
+            std::vector<std::uint8_t> myBytes;
+            std::vector<size_t> myLabels;
+            std::vector<std::pair<size_t, Label>> myFixups;
+        };
+
+        class CodeGenerator
+        {
+        public:
+            using Label = Assembler::Label;
+
+            // Empty when the graph has a fragment the generated code could not match the way Match does
+            std::optional<std::vector<std::uint8_t>> Generate(const Fragment* aRoot)
+            {
+                Label root = EntryOf(aRoot);
+                Label fail = myAssembler.NewLabel();
+                Label out  = myAssembler.NewLabel();
+
+                myAssembler.Bytes({0x53});              // push rbx
+                myAssembler.Bytes({0x41, 0x54});        // push r12
+                myAssembler.Bytes({0x41, 0x55});        // push r13
+                myAssembler.Bytes({0x41, 0x56});        // push r14
+                myAssembler.Bytes({0x48, 0x89, 0xFB});  // mov rbx, rdi
+                myAssembler.Bytes({0x49, 0x89, 0xF4});  // mov r12, rsi
+                myAssembler.Bytes({0x49, 0x89, 0xD5});  // mov r13, rdx
+                myAssembler.Bytes({0x49, 0x89, 0xCE});  // mov r14, rcx
+                myAssembler.Call(root);
+                myAssembler.Bytes({0x84, 0xC0});  // test al, al
+                myAssembler.JumpIf(Assembler::Equal, fail);
+                myAssembler.Bytes({0x48, 0x89, 0xD8});  // mov rax, rbx
+                myAssembler.Jump(out);
+                myAssembler.Bind(fail);
+                myAssembler.Bytes({0x31, 0xC0});  // xor eax, eax
+                myAssembler.Bind(out);
+                myAssembler.Bytes({0x41, 0x5E});  // pop r14
+                myAssembler.Bytes({0x41, 0x5D});  // pop r13
+                myAssembler.Bytes({0x41, 0x5C});  // pop r12
+                myAssembler.Bytes({0x5B});        // pop rbx
+                myAssembler.Bytes({0xC3});        // ret
+
+                while (!myPending.empty())
+                {
+                    const Fragment* fragment = myPending.back();
+                    myPending.pop_back();
+
+                    myAssembler.Align(16);
+                    myAssembler.Bind(myEntries.at(fragment));
+                    EmitFunction(fragment);
+                }
+
+                for (auto& [label, table] : myTables)
+                {
+                    myAssembler.Align(64);
+                    myAssembler.Bind(label);
+                    for (std::uint8_t member : table) myAssembler.Bytes({member});
+                }
+
+                if (!myLowered)
+                    return {};
+
+                return myAssembler.Finish();
+            }
+
+        private:
+            Label EntryOf(const Fragment* aFragment)
+            {
+                auto it = myEntries.find(aFragment);
+                if (it != myEntries.end())
+                    return it->second;
+
+                Label label = myAssembler.NewLabel();
+                myEntries.emplace(aFragment, label);
+                myPending.push_back(aFragment);
+
+                return label;
+            }
+
+            bool IsLeaf(const Fragment* aFragment)
+            {
+                switch (aFragment->GetType())
+                {
+                    case Fragment::Type::Literal:
+                    case Fragment::Type::String:
+                    case Fragment::Type::CharClass:
+                        return true;
+                    case Fragment::Type::Alternative:
+                        return aFragment->LookupPortion() > 0
+                            && aFragment->LookupPortion() == aFragment->SubFragments().size();
+                    default:
+                        return false;
+                }
+            }
+
+            void EmitLiteral(Fragment::Literal aLiteral, Label aOnFail)
+            {
+                myAssembler.Bytes({0x4C, 0x39, 0xE3});  // cmp rbx, r12
+                myAssembler.JumpIf(Assembler::AboveOrEqual, aOnFail);
+                myAssembler.Bytes({0x80, 0x3B, aLiteral});  // cmp byte [rbx], literal
+                myAssembler.JumpIf(Assembler::NotEqual, aOnFail);
+                myAssembler.Bytes({0x48, 0xFF, 0xC3});  // inc rbx
+            }
+
+            // Checks the remaining length once, then compares the string 8, 4, 2 and 1 bytes at a time against
+            // immediates
+            void EmitString(std::string_view aString, Label aOnFail)
+            {
+                std::uint32_t size = static_cast<std::uint32_t>(aString.size());
+                std::uint32_t at   = 0;
+
+                auto chunk = [&aString, &at](size_t aBytes) {
+                    std::uint64_t value = 0;
+                    std::memcpy(&value, aString.data() + at, aBytes);
+                    return value;
+                };
+
+                myAssembler.Bytes({0x4C, 0x89, 0xE0});  // mov rax, r12
+                myAssembler.Bytes({0x48, 0x29, 0xD8});  // sub rax, rbx
+                myAssembler.Bytes({0x48, 0x3D});        // cmp rax, size
+                myAssembler.Immediate32(size);
+                myAssembler.JumpIf(Assembler::Below, aOnFail);
+
+                for (; at + 8 <= size; at += 8)
+                {
+                    myAssembler.Bytes({0x48, 0xB8});  // mov rax, chunk
+                    myAssembler.Immediate64(chunk(8));
+                    myAssembler.Bytes({0x48, 0x39, 0x83});  // cmp [rbx + at], rax
+                    myAssembler.Immediate32(at);
+                    myAssembler.JumpIf(Assembler::NotEqual, aOnFail);
+                }
+
+                if (at + 4 <= size)
+                {
+                    myAssembler.Bytes({0x81, 0xBB});  // cmp dword [rbx + at], chunk
+                    myAssembler.Immediate32(at);
+                    myAssembler.Immediate32(static_cast<std::uint32_t>(chunk(4)));
+                    myAssembler.JumpIf(Assembler::NotEqual, aOnFail);
+                    at += 4;
+                }
+
+                if (at + 2 <= size)
+                {
+                    myAssembler.Bytes({0x66, 0x81, 0xBB});  // cmp word [rbx + at], chunk
+                    myAssembler.Immediate32(at);
+                    myAssembler.Immediate16(static_cast<std::uint16_t>(chunk(2)));
+                    myAssembler.JumpIf(Assembler::NotEqual, aOnFail);
+                    at += 2;
+                }
+
+                if (at < size)
+                {
+                    myAssembler.Bytes({0x80, 0xBB});  // cmp byte [rbx + at], chunk
+                    myAssembler.Immediate32(at);
+                    myAssembler.Bytes({static_cast<std::uint8_t>(chunk(1))});
+                    myAssembler.JumpIf(Assembler::NotEqual, aOnFail);
+                }
+
+                myAssembler.Bytes({0x48, 0x81, 0xC3});  // add rbx, size
+                myAssembler.Immediate32(size);
+            }
+
+            // Matches the literal portion of an alternative through a 256 byte membership table
+            void EmitLookup(const Fragment* aAlternative, Label aOnFail)
+            {
+                std::array<std::uint8_t, 256> table;
+                for (size_t i = 0; i < table.size(); i++)
+                    table[i] = aAlternative->LookupIndex(static_cast<Fragment::Literal>(i)) != Fragment::NoIndex;
+
+                EmitTable(table, aOnFail);
+            }
+
+            void EmitClass(const CharClass& aClass, Label aOnFail)
+            {
+                std::array<std::uint8_t, 256> table;
+                for (size_t i = 0; i < table.size(); i++) table[i] = aClass.Contains(static_cast<Fragment::Literal>(i));
+
+                EmitTable(table, aOnFail);
+            }
+
+            void EmitTable(const std::array<std::uint8_t, 256>& aTable, Label aOnFail)
+            {
+                Label label = myAssembler.NewLabel();
+                myTables.push_back({label, aTable});
+
+                myAssembler.Bytes({0x4C, 0x39, 0xE3});  // cmp rbx, r12
+                myAssembler.JumpIf(Assembler::AboveOrEqual, aOnFail);
+                myAssembler.Bytes({0x0F, 0xB6, 0x03});  // movzx eax, byte [rbx]
+                myAssembler.Bytes({0x48, 0x8D, 0x0D});  // lea rcx, [rip + table]
+                myAssembler.Relative(label);
+                myAssembler.Bytes({0x80, 0x3C, 0x01, 0x00});  // cmp byte [rcx + rax], 0
+                myAssembler.JumpIf(Assembler::Equal, aOnFail);
+                myAssembler.Bytes({0x48, 0xFF, 0xC3});  // inc rbx
+            }
+
+            void EmitChild(const Fragment* aFragment, Label aOnFail)
+            {
+                if (IsLeaf(aFragment))
+                {
+                    if (aFragment->GetType() == Fragment::Type::Literal)
+                        EmitLiteral(aFragment->GetLiteral(), aOnFail);
+                    else if (aFragment->GetType() == Fragment::Type::String)
+                        EmitString(aFragment->GetString(), aOnFail);
+                    else if (aFragment->GetType() == Fragment::Type::CharClass)
+                        EmitClass(aFragment->GetClass(), aOnFail);
+                    else
+                        EmitLookup(aFragment, aOnFail);  // an alternative of literals only
+                    return;
+                }
+
+                myAssembler.Call(EntryOf(aFragment));
+                myAssembler.Bytes({0x84, 0xC0});  // test al, al
+                myAssembler.JumpIf(Assembler::Equal, aOnFail);
+            }
+
+            void EmitFunction(const Fragment* aFragment)
+            {
+                Label depthExceeded = myAssembler.NewLabel();
+                Label success       = myAssembler.NewLabel();
+                Label fail          = myAssembler.NewLabel();
+                Label epilogue      = myAssembler.NewLabel();
+
+                myAssembler.Bytes({0x4D, 0x85, 0xED});  // test r13, r13
+                myAssembler.JumpIf(Assembler::Equal, depthExceeded);
+                myAssembler.Bytes({0x4C, 0x39, 0xF4});  // cmp rsp, r14
+                myAssembler.JumpIf(Assembler::Below, depthExceeded);
+                myAssembler.Bytes({0x49, 0xFF, 0xCD});  // dec r13
+
+                switch (aFragment->GetType())
+                {
+                    case Fragment::Type::Sequence:
+                        for (const Fragment* sub : aFragment->SubFragments()) EmitChild(sub, fail);
+                        myAssembler.Jump(success);
+                        break;
+
+                    case Fragment::Type::Alternative:
+                        EmitAlternative(aFragment, success, fail);
+                        break;
+
+                    case Fragment::Type::Repeat:
+                        EmitRepeat(aFragment, success, fail);
+                        break;
+
+                    default:
+                        if (!IsLeaf(aFragment))
+                        {
+                            myLowered = false;
+                            myAssembler.Jump(fail);
+                            break;
+                        }
+
+                        EmitChild(aFragment, fail);
+                        myAssembler.Jump(success);
+                        break;
+                }
+
+                myAssembler.Bind(success);
+                myAssembler.Bytes({0xB0, 0x01});  // mov al, 1
+                myAssembler.Jump(epilogue);
+                myAssembler.Bind(fail);
+                myAssembler.Bytes({0x31, 0xC0});  // xor eax, eax
+                myAssembler.Bind(epilogue);
+                myAssembler.Bytes({0x49, 0xFF, 0xC5});  // inc r13
+                myAssembler.Bytes({0xC3});              // ret
+                myAssembler.Bind(depthExceeded);
+                myAssembler.Bytes({0x31, 0xC0});  // xor eax, eax
+                myAssembler.Bytes({0xC3});        // ret
+            }
+
+            void EmitAlternative(const Fragment* aFragment, Label aSuccess, Label aFail)
+            {
+                Fragment::Children subFragments = aFragment->SubFragments();
+                size_t portion                  = aFragment->LookupPortion();
+
+                Label matched = myAssembler.NewLabel();
+                Label failed  = myAssembler.NewLabel();
+
+                myAssembler.Bytes({0x53});  // push rbx
+
+                if (portion > 0)
+                {
+                    Label next = myAssembler.NewLabel();
+                    EmitLookup(aFragment, next);
+                    myAssembler.Jump(matched);
+                    myAssembler.Bind(next);
+                    myAssembler.Bytes({0x48, 0x8B, 0x1C, 0x24});  // mov rbx, [rsp]
+                }
+
+                for (size_t i = portion; i < subFragments.size(); i++)
+                {
+                    Label next = myAssembler.NewLabel();
+                    EmitChild(subFragments[i], next);
+                    myAssembler.Jump(matched);
+                    myAssembler.Bind(next);
+                    myAssembler.Bytes({0x48, 0x8B, 0x1C, 0x24});  // mov rbx, [rsp]
+                }
+
+                myAssembler.Jump(failed);
+
+                myAssembler.Bind(matched);
+                myAssembler.Bytes({0x48, 0x83, 0xC4, 0x08});  // add rsp, 8
+                myAssembler.Jump(aSuccess);
+                myAssembler.Bind(failed);
+                myAssembler.Bytes({0x48, 0x83, 0xC4, 0x08});  // add rsp, 8
+                myAssembler.Jump(aFail);
+            }
+
+            void EmitRepeat(const Fragment* aFragment, Label aSuccess, Label aFail)
+            {
+                RepeatCount count    = aFragment->GetCount();
+                const Fragment* item = aFragment->SubFragments()[0];
+
+                // Match runs an unbounded repeat of an empty match until it is out of steps and fails as a whole, a
+                // loop here would fail only the repeat. Items that may match empty are left to the interpreter.
+                if (count.myMax == RepeatCount::Unbounded && (!item->IsAnalyzed() || item->IsNullable()))
+                    myLowered = false;
+
+                Label loop   = myAssembler.NewLabel();
+                Label stop   = myAssembler.NewLabel();
+                Label done   = myAssembler.NewLabel();
+                Label failed = myAssembler.NewLabel();
+
+                // [rsp + 8]: end of the last successful iteration, [rsp]: iterations so far
+                myAssembler.Bytes({0x53});        // push rbx
+                myAssembler.Bytes({0x6A, 0x00});  // push 0
+
+                myAssembler.Bind(loop);
+                if (count.myMax != RepeatCount::Unbounded)
+                {
+                    myAssembler.Bytes({0x48, 0xB8});  // mov rax, max
+                    myAssembler.Immediate64(count.myMax);
+                    myAssembler.Bytes({0x48, 0x39, 0x04, 0x24});  // cmp [rsp], rax
+                    myAssembler.JumpIf(Assembler::AboveOrEqual, done);
+                }
+
+                EmitChild(item, stop);
+
+                myAssembler.Bytes({0x48, 0xFF, 0x04, 0x24});        // inc qword [rsp]
+                myAssembler.Bytes({0x48, 0x89, 0x5C, 0x24, 0x08});  // mov [rsp + 8], rbx
+                myAssembler.Jump(loop);
+
+                myAssembler.Bind(stop);
+                myAssembler.Bytes({0x48, 0x8B, 0x5C, 0x24, 0x08});  // mov rbx, [rsp + 8]
+                if (count.myMin > 0)
+                {
+                    myAssembler.Bytes({0x48, 0xB8});  // mov rax, min
+                    myAssembler.Immediate64(count.myMin);
+                    myAssembler.Bytes({0x48, 0x39, 0x04, 0x24});  // cmp [rsp], rax
+                    myAssembler.JumpIf(Assembler::Below, failed);
+                }
+
+                myAssembler.Bind(done);
+                myAssembler.Bytes({0x48, 0x83, 0xC4, 0x10});  // add rsp, 16
+                myAssembler.Jump(aSuccess);
+                myAssembler.Bind(failed);
+                myAssembler.Bytes({0x48, 0x83, 0xC4, 0x10});  // add rsp, 16
+                myAssembler.Jump(aFail);
+            }
+
+            Assembler myAssembler;
+
+            std::unordered_map<const Fragment*, Label> myEntries;
+            std::vector<const Fragment*> myPending;
+            std::vector<std::pair<Label, std::array<std::uint8_t, 256>>> myTables;
+
+            bool myLowered = true;
+        };
+
+#endif
+    }  // namespace
+
+    bool JitProgram::Supported() { return PATTERN_MATCHER_JIT; }
+
+    const void* JitProgram::StackLimit()
+    {
+#if PATTERN_MATCHER_JIT
+        // Room left below the limit for the few pushes a function makes after its check, and for signal handlers
+        constexpr size_t margin = 64 * 1024;
+
+        thread_local const void* limit = []() -> const void* {
+            pthread_attr_t attributes;
+            void* low   = nullptr;
+            size_t size = 0;
+
+            bool known = pthread_getattr_np(pthread_self(), &attributes) == 0;
+            if (known)
+            {
+                known = pthread_attr_getstack(&attributes, &low, &size) == 0;
+                pthread_attr_destroy(&attributes);
+            }
+
+            // Without the bounds of the stack the JIT may use what the smallest thread stacks have
+            if (!known || size <= margin)
+                return static_cast<const char*>(__builtin_frame_address(0)) - 256 * 1024 + margin;
+
+            return static_cast<const char*>(low) + margin;
+        }();
+
+        return limit;
+#else
+        return nullptr;
+#endif
+    }
+
+    std::optional<JitProgram> JitProgram::Compile(const Fragment* aRoot)
+    {
+        assert(aRoot);
+
+#if PATTERN_MATCHER_JIT
+        std::optional<std::vector<std::uint8_t>> generated = CodeGenerator().Generate(aRoot);
+        if (!generated)
+            return {};
+
+        std::vector<std::uint8_t>& code = *generated;
+
+        void* memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+            return {};
+
+        std::memcpy(memory, code.data(), code.size());
+
+        if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0)
+        {
+            munmap(memory, code.size());
+            return {};
+        }
+
+        return JitProgram(memory, code.size());
+#else
+        return {};
+#endif
+    }
+
+    JitProgram::JitProgram(void* aCode, size_t aSize)
+        : myCode(aCode), mySize(aSize), myEntry(reinterpret_cast<Entry>(aCode))
+    {
+    }
+
+    JitProgram::JitProgram(JitProgram&& aOther)
+        : myCode(std::exchange(aOther.myCode, nullptr))
+        , mySize(std::exchange(aOther.mySize, 0))
+        , myEntry(std::exchange(aOther.myEntry, nullptr))
+    {
+    }
+
+    JitProgram& JitProgram::operator=(JitProgram&& aOther)
+    {
+        std::swap(myCode, aOther.myCode);
+        std::swap(mySize, aOther.mySize);
+        std::swap(myEntry, aOther.myEntry);
+
+        return *this;
+    }
+
+    JitProgram::~JitProgram()
+    {
+#if PATTERN_MATCHER_JIT
+        if (myCode)
+            munmap(myCode, mySize);
+#endif
+    }
+}  // namespace pattern_matcher
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+
+#include "pattern_matcher/Fragment.h"
+
+namespace pattern_matcher
+{
+    // Native x86-64 code generated from a fragment graph, only available on linux. Every non-leaf fragment becomes a
+    // function, literals and all-literal alternatives are inlined as compares and table lookups, repeats become loops.
+    //
+    // The JIT only recognizes input, it reports where a match ends without building a Success tree. Like Program the
+    // depth limit counts nested non-leaf fragments. Nesting also recurses natively, so a match that would get close to
+    // the end of the thread's stack fails as if it had reached the depth limit, whatever aMaxDepth allows.
+    class JitProgram
+    {
+    public:
+        static bool Supported();
+
+        // Returns an empty optional when the platform is unsupported, executable memory could not be mapped or the graph
+        // has a fragment the JIT does not lower. Unbounded repeats of items that may match empty are not lowered, as
+        // Match fails on them by running out of steps.
+        static std::optional<JitProgram> Compile(const Fragment* aRoot);
+
+        JitProgram(const JitProgram&)            = delete;
+        JitProgram& operator=(const JitProgram&) = delete;
+
+        JitProgram(JitProgram&& aOther);
+        JitProgram& operator=(JitProgram&& aOther);
+
+        ~JitProgram();
+
+        size_t CodeSize() const { return mySize; }
+
+        template<std::contiguous_iterator Iterator>
+        std::optional<Iterator> Match(Iterator aBegin, Iterator aEnd, size_t aMaxDepth = 2'048) const
+        {
+            const unsigned char* begin = reinterpret_cast<const unsigned char*>(std::to_address(aBegin));
+            const unsigned char* end   = begin + (aEnd - aBegin);
+
+            const unsigned char* at = myEntry(begin, end, aMaxDepth, StackLimit());
+
+            if (!at)
+                return {};
+
+            return aBegin + (at - begin);
+        }
+
+        template<std::ranges::contiguous_range Range>
+        std::optional<std::ranges::iterator_t<Range>> Match(Range& aRange, size_t aMaxDepth = 2'048) const
+        {
+            return Match(std::ranges::begin(aRange), std::ranges::begin(aRange) + std::ranges::size(aRange),
+                         aMaxDepth);
+        }
+
+    private:
+        using Entry = const unsigned char* (*)(const unsigned char* aBegin, const unsigned char* aEnd,
+                                               size_t aMaxDepth, const void* aStackLimit);
+
+        // Lowest address the stack of the calling thread may grow to while matching
+        static const void* StackLimit();
+
+        JitProgram(void* aCode, size_t aSize);
+
+        void* myCode;
+        size_t mySize;
+        Entry myEntry;
+    };
+}  // namespace pattern_matcher
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace pattern_matcher
+{
+    // Input of single bytes in contiguous memory is matched as raw pointers, so the matching loop is instantiated once
+    // for std::string, std::string_view, std::vector<char>, spans and pointers alike. Positions are mapped back to the
+    // caller's iterators by Rebase only when results are produced.
+    template<class Iterator, class Sentinel>
+    concept ByteContiguous = std::contiguous_iterator<Iterator> && std::sized_sentinel_for<Sentinel, Iterator>
+                          && sizeof(std::iter_value_t<Iterator>) == 1;
+
+    template<class Iterator, class Sentinel>
+    auto Lower(Iterator aBegin, Sentinel aEnd)
+    {
+        if constexpr (ByteContiguous<Iterator, Sentinel>)
+        {
+            const unsigned char* begin = reinterpret_cast<const unsigned char*>(std::to_address(aBegin));
+            return std::pair<const unsigned char*, const unsigned char*>(begin, begin + (aEnd - aBegin));
+        }
+        else
+        {
+            return std::pair<Iterator, Sentinel>(aBegin, aEnd);
+        }
+    }
+
+    // Maps a position in the lowered input back to the caller's iterator
+    template<class Iterator, class Core>
+    class Rebase
+    {
+    public:
+        Rebase(Iterator aBegin, Core aCoreBegin) : myBegin(aBegin), myCoreBegin(aCoreBegin) {}
+
+        Iterator operator()(Core aAt) const { return myBegin + (aAt - myCoreBegin); }
+
+    private:
+        Iterator myBegin;
+        Core myCoreBegin;
+    };
+
+    template<class Iterator>
+    class Rebase<Iterator, Iterator>
+    {
+    public:
+        Rebase(Iterator, Iterator) {}
+
+        Iterator operator()(Iterator aAt) const { return aAt; }
+    };
+}  // namespace pattern_matcher
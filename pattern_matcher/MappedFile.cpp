@@ -0,0 +1,82 @@
+#include "pattern_matcher/MappedFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PATTERN_MATCHER_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define PATTERN_MATCHER_MMAP 0
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace pattern_matcher
+{
+    std::shared_ptr<const MappedFile> MappedFile::Open(const std::filesystem::path& aPath)
+    {
+        std::shared_ptr<MappedFile> out(new MappedFile());
+
+#if PATTERN_MATCHER_MMAP
+        int file = ::open(aPath.c_str(), O_RDONLY);
+        if (file == -1)
+            return nullptr;
+
+        struct stat status;
+        if (::fstat(file, &status) == -1 || !S_ISREG(status.st_mode))
+        {
+            ::close(file);
+            return nullptr;
+        }
+
+        // mmap refuses zero length mappings, an empty file is just an empty range
+        if (status.st_size == 0)
+        {
+            ::close(file);
+            return out;
+        }
+
+        int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+        // Fault the whole file in up front, matching reads all of it anyway
+        flags |= MAP_POPULATE;
+#endif
+
+        size_t size   = static_cast<size_t>(status.st_size);
+        void* mapping = ::mmap(nullptr, size, PROT_READ, flags, file, 0);
+
+        // The mapping keeps its own reference to the file
+        ::close(file);
+
+        if (mapping == MAP_FAILED)
+            return nullptr;
+
+#if defined(MADV_SEQUENTIAL)
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+#endif
+
+        out->myData   = static_cast<const char*>(mapping);
+        out->mySize   = size;
+        out->myMapped = true;
+#else
+        std::ifstream in(aPath, std::ios::binary);
+        if (!in)
+            return nullptr;
+
+        out->myBuffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        out->myData = out->myBuffer.data();
+        out->mySize = out->myBuffer.size();
+#endif
+
+        return out;
+    }
+
+    MappedFile::~MappedFile()
+    {
+#if PATTERN_MATCHER_MMAP
+        if (myMapped)
+            ::munmap(const_cast<char*>(myData), mySize);
+#endif
+    }
+}  // namespace pattern_matcher
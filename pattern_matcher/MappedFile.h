@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "pattern_matcher/Fragment.h"
+#include "pattern_matcher/PatternMatchingTypes.h"
+
+namespace pattern_matcher
+{
+    // A file mapped read only into memory, matched over directly instead of being copied into a string. Empty files
+    // are not mapped and give an empty range. Where mmap is not available the file is read into a buffer instead.
+    class MappedFile
+    {
+    public:
+        // nullptr when the file can not be opened or mapped
+        static std::shared_ptr<const MappedFile> Open(const std::filesystem::path& aPath);
+
+        MappedFile(const MappedFile&)            = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile();
+
+        const char* begin() const { return myData; }
+        const char* end() const { return myData + mySize; }
+
+        const char* Data() const { return myData; }
+        size_t Size() const { return mySize; }
+        bool Empty() const { return mySize == 0; }
+
+        std::string_view View() const { return std::string_view(myData, mySize); }
+
+    private:
+        MappedFile() = default;
+
+        const char* myData = nullptr;
+        size_t mySize      = 0;
+        bool myMapped      = false;
+
+        std::vector<char> myBuffer;
+    };
+
+    // A match over a MappedFile, holds on to the file so the positions in the tree stay valid for as long as the match
+    // is kept around
+    struct FileMatch
+    {
+        std::shared_ptr<const MappedFile> myFile;
+        Success<const char*> myMatch;
+
+        const Success<const char*>& operator*() const { return myMatch; }
+        const Success<const char*>* operator->() const { return &myMatch; }
+    };
+}  // namespace pattern_matcher
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "pattern_matcher/Lowering.h"
+#include "pattern_matcher/ParseTree.h"
+#include "pattern_matcher/PatternMatchingTypes.h"
+
+namespace pattern_matcher
+{
+    // Builders decide what PatternMatcher::Match produces from a successful match. The matcher notifies them as
+    // contexts are entered and left:
+    //
+    //   Enter(context)                    aContext was pushed
+    //   Leave(context, success, parent)   aContext matched, aParent is null for the root
+    //   Abandon(context)                  aContext failed
+    //   Span(context, success)            aContext matched a run of single byte children without pushing them, see
+    //                                     Fragment::IsSpan. Called before Leave.
+    //
+    // Memoized fragments are stored as a Product, taken with Snapshot(context, success) and given to a later parent
+    // with Replay(product, parent).
+    //
+    // The matcher runs on Core positions, see Lowering.h, builders produce results in terms of the caller's Iterator.
+
+    // Builds nothing, only remembers where the root match ended
+    template<class Iterator, class Core = Iterator>
+    class RecognizeBuilder
+    {
+    public:
+        struct Product
+        {
+        };
+
+        RecognizeBuilder(Rebase<Iterator, Core> aRebase) : myRebase(aRebase) {}
+
+        void Enter(MatchContext<Core>& aContext) {}
+
+        void Leave(MatchContext<Core>& aContext, const Success<Core>& aSuccess, MatchContext<Core>* aParent)
+        {
+            if (!aParent)
+                myEnd = aSuccess.myEnd;
+        }
+
+        void Abandon(MatchContext<Core>& aContext) {}
+
+        void Span(MatchContext<Core>& aContext, const Success<Core>& aSuccess) {}
+
+        Product Snapshot(MatchContext<Core>& aContext, const Success<Core>& aSuccess) { return {}; }
+
+        void Replay(const Product& aProduct, MatchContext<Core>& aParent) {}
+
+        Iterator Result() const { return myRebase(*myEnd); }
+
+        // Starts over on another input
+        void Reset(Rebase<Iterator, Core> aRebase)
+        {
+            myRebase = aRebase;
+            myEnd.reset();
+        }
+
+    private:
+        Rebase<Iterator, Core> myRebase;
+        std::optional<Core> myEnd;
+    };
+
+    // Builds a tree of Success, collecting the sub matches of each open fragment on a stack parallel to the contexts
+    template<class Iterator, class Core = Iterator>
+    class TreeBuilder
+    {
+    public:
+        using Product = Success<Iterator>;
+
+        TreeBuilder(Rebase<Iterator, Core> aRebase) : myRebase(aRebase) { myOpen.reserve(InitialCapacity); }
+
+        void Enter(MatchContext<Core>& aContext) { myOpen.emplace_back(); }
+
+        void Leave(MatchContext<Core>& aContext, const Success<Core>& aSuccess, MatchContext<Core>* aParent)
+        {
+            std::vector<Success<Iterator>> children = std::move(myOpen.back());
+            myOpen.pop_back();
+
+            if (!aParent)
+            {
+                myResult = Success<Iterator>{aSuccess.myFragment, myRebase(aSuccess.myBegin), myRebase(aSuccess.myEnd),
+                                             std::move(children)};
+                return;
+            }
+
+            if (!aSuccess.myFragment->IsCaptured())
+            {
+                Splice(std::move(children));
+                return;
+            }
+
+            myOpen.back().push_back(Success<Iterator>{aSuccess.myFragment, myRebase(aSuccess.myBegin),
+                                                      myRebase(aSuccess.myEnd), std::move(children)});
+        }
+
+        void Abandon(MatchContext<Core>& aContext) { myOpen.pop_back(); }
+
+        void Span(MatchContext<Core>& aContext, const Success<Core>& aSuccess)
+        {
+            const Fragment* child = aSuccess.myFragment->SubFragments()[0];
+
+            if (!child->IsCaptured())
+                return;
+
+            std::vector<Success<Iterator>>& children = myOpen.back();
+            children.reserve(children.size() + (aSuccess.myEnd - aSuccess.myBegin));
+
+            for (Core at = aSuccess.myBegin; at != aSuccess.myEnd; ++at)
+                children.push_back(Success<Iterator>{child, myRebase(at), myRebase(std::next(at))});
+        }
+
+        Product Snapshot(MatchContext<Core>& aContext, const Success<Core>& aSuccess)
+        {
+            return Success<Iterator>{aSuccess.myFragment, myRebase(aSuccess.myBegin), myRebase(aSuccess.myEnd),
+                                     myOpen.back()};
+        }
+
+        void Replay(const Product& aProduct, MatchContext<Core>& aParent)
+        {
+            std::vector<Success<Iterator>>& children = myOpen.back();
+
+            if (aProduct.myFragment->IsCaptured())
+                children.push_back(aProduct);
+            else
+                children.insert(std::end(children), std::begin(aProduct.mySubMatches), std::end(aProduct.mySubMatches));
+        }
+
+        Success<Iterator>&& Result() { return std::move(*myResult); }
+
+        // Starts over on another input, keeping the capacity of the open stack
+        void Reset(Rebase<Iterator, Core> aRebase)
+        {
+            myRebase = aRebase;
+            myOpen.clear();
+            myResult.reset();
+        }
+
+    private:
+        // Matches rarely nest deeper than this, see PatternMatcher::InitialContextCapacity
+        static constexpr size_t InitialCapacity = 64;
+
+        void Splice(std::vector<Success<Iterator>>&& aChildren)
+        {
+            std::vector<Success<Iterator>>& parent = myOpen.back();
+
+            if (parent.empty())
+            {
+                parent = std::move(aChildren);
+                return;
+            }
+
+            for (Success<Iterator>& child : aChildren) parent.push_back(std::move(child));
+        }
+
+        Rebase<Iterator, Core> myRebase;
+        std::vector<std::vector<Success<Iterator>>> myOpen;
+        std::optional<Success<Iterator>> myResult;
+    };
+
+    // Appends nodes to a ParseTree in preorder, a failed fragment truncates the tree back to where it started. Fragments
+    // that are not captured only record where their children start.
+    template<class Iterator, class Core = Iterator>
+    class FlatTreeBuilder
+    {
+    public:
+        using Node    = typename ParseTree<Iterator>::Node;
+        using Product = std::vector<Node>;
+
+        FlatTreeBuilder(ParseTree<Iterator>& aTree, Iterator aBegin, Core aCoreBegin)
+            : myTree(aTree), myCoreBegin(aCoreBegin)
+        {
+            myTree.myBegin = aBegin;
+            myTree.myNodes.clear();
+            myTree.myOpen.clear();
+        }
+
+        void Enter(MatchContext<Core>& aContext)
+        {
+            bool root = myTree.myOpen.empty();
+
+            myTree.myOpen.push_back(myTree.myNodes.size());
+
+            if (root || aContext.myFragment->IsCaptured())
+            {
+                size_t offset = aContext.myBegin - myCoreBegin;
+                myTree.myNodes.push_back(Node{aContext.myFragment, offset, offset, 1});
+            }
+        }
+
+        void Leave(MatchContext<Core>& aContext, const Success<Core>& aSuccess, MatchContext<Core>* aParent)
+        {
+            if (!aParent || aContext.myFragment->IsCaptured())
+            {
+                Node& node = myTree.myNodes[myTree.myOpen.back()];
+
+                node.myEnd  = aSuccess.myEnd - myCoreBegin;
+                node.mySize = static_cast<std::uint32_t>(myTree.myNodes.size() - myTree.myOpen.back());
+            }
+
+            myTree.myOpen.pop_back();
+        }
+
+        void Abandon(MatchContext<Core>& aContext)
+        {
+            myTree.myNodes.resize(myTree.myOpen.back());
+            myTree.myOpen.pop_back();
+        }
+
+        void Span(MatchContext<Core>& aContext, const Success<Core>& aSuccess)
+        {
+            const Fragment* child = aSuccess.myFragment->SubFragments()[0];
+
+            if (!child->IsCaptured())
+                return;
+
+            size_t begin = aSuccess.myBegin - myCoreBegin;
+            size_t end   = aSuccess.myEnd - myCoreBegin;
+
+            for (size_t at = begin; at < end; at++) myTree.myNodes.push_back(Node{child, at, at + 1, 1});
+        }
+
+        Product Snapshot(MatchContext<Core>& aContext, const Success<Core>& aSuccess)
+        {
+            Product out(std::begin(myTree.myNodes) + myTree.myOpen.back(), std::end(myTree.myNodes));
+
+            // A fragment that is not captured leaves only its children
+            if (!aContext.myFragment->IsCaptured())
+                return out;
+
+            out[0].myEnd  = aSuccess.myEnd - myCoreBegin;
+            out[0].mySize = static_cast<std::uint32_t>(out.size());
+
+            return out;
+        }
+
+        void Replay(const Product& aProduct, MatchContext<Core>& aParent)
+        {
+            myTree.myNodes.insert(std::end(myTree.myNodes), std::begin(aProduct), std::end(aProduct));
+        }
+
+    private:
+        ParseTree<Iterator>& myTree;
+        Core myCoreBegin;
+    };
+}  // namespace pattern_matcher
@@ -0,0 +1,109 @@
+#include "pattern_matcher/MatchSession.h"
+
+#include <algorithm>
+
+namespace pattern_matcher
+{
+    static_assert(std::sentinel_for<StreamEnd, StreamPosition>);
+
+    MatchSession::MatchSession(const Fragment* aRoot, size_t aMaxDepth) : myMaxDepth(aMaxDepth)
+    {
+        myContexts.push_back(aRoot->BeginMatch(StreamPosition(this, 0)));
+    }
+
+    size_t MatchSession::Feed(std::span<const unsigned char> aChunk)
+    {
+        if (Done())
+            return myReleased;
+
+        myWindow.insert(std::end(myWindow), std::begin(aChunk), std::end(aChunk));
+
+        Step();
+        Release();
+
+        return myReleased;
+    }
+
+    size_t MatchSession::Feed(std::string_view aChunk)
+    {
+        return Feed(std::span<const unsigned char>(reinterpret_cast<const unsigned char*>(aChunk.data()), aChunk.size()));
+    }
+
+    std::optional<size_t> MatchSession::Finish()
+    {
+        myFinished = true;
+        Step();
+
+        return myEnd;
+    }
+
+    void MatchSession::Step()
+    {
+        while (!myContexts.empty())
+        {
+            MatchContext<StreamPosition>& ctx   = myContexts.back();
+            MatchContext<StreamPosition> before = ctx;
+
+            myStarved = false;
+
+            Result<StreamPosition> result = ctx.myFragment->ResumeMatch(ctx, myLastResult, StreamEnd(this));
+
+            if (myStarved)
+            {
+                // The step needs input that has not arrived yet, it is redone from the same state on the next feed
+                ctx = before;
+                return;
+            }
+
+            myLastResult = std::move(result);
+
+            switch (myLastResult.GetType())
+            {
+                case MatchResultType::Success:
+                    if (myContexts.size() == 1)
+                        myEnd = myLastResult.Success().myEnd.Offset();
+
+                    myContexts.pop_back();
+                    break;
+
+                case MatchResultType::Failure:
+                    myContexts.pop_back();
+                    break;
+
+                case MatchResultType::InProgress:
+                    if (myContexts.size() >= myMaxDepth)
+                    {
+                        myLastResult = MatchFailure{};
+                        break;
+                    }
+
+                    myContexts.push_back(myLastResult.TakeContext());
+                    myLastResult = {};
+                    break;
+
+                case MatchResultType::None:
+                    assert(false);
+                    break;
+            }
+        }
+    }
+
+    void MatchSession::Release()
+    {
+        size_t lowest = Available();
+
+        if (!myContexts.empty())
+            lowest = std::min(lowest, myContexts.back().myAt.Offset());
+
+        // Alternatives read their first byte again to pick the next branch when one fails, the rest only move forward
+        for (const MatchContext<StreamPosition>& ctx : myContexts)
+        {
+            if (ctx.myFragment->GetType() == Fragment::Type::Alternative
+                && static_cast<size_t>(ctx.myIndex) < ctx.myFragment->SubFragments().size())
+                lowest = std::min(lowest, ctx.myBegin.Offset());
+        }
+
+        myWindow.erase(std::begin(myWindow), std::begin(myWindow) + (lowest - myReleased));
+        myReleased = lowest;
+    }
+}  // namespace pattern_matcher
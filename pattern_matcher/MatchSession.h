@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "pattern_matcher/Fragment.h"
+#include "pattern_matcher/PatternMatchingTypes.h"
+
+namespace pattern_matcher
+{
+    class MatchSession;
+
+    // A position in a streamed input, kept as an offset from the start of the stream so it stays valid as the session
+    // drops input from the front of its window
+    class StreamPosition
+    {
+    public:
+        using value_type      = unsigned char;
+        using difference_type = std::ptrdiff_t;
+
+        StreamPosition() = default;
+        StreamPosition(const MatchSession* aSession, size_t aOffset) : mySession(aSession), myOffset(aOffset) {}
+
+        unsigned char operator*() const;
+
+        StreamPosition& operator++()
+        {
+            myOffset++;
+            return *this;
+        }
+        StreamPosition operator++(int)
+        {
+            StreamPosition out = *this;
+            myOffset++;
+            return out;
+        }
+
+        StreamPosition operator+(difference_type aAmount) const { return StreamPosition(mySession, myOffset + aAmount); }
+        difference_type operator-(const StreamPosition& aOther) const
+        {
+            return static_cast<difference_type>(myOffset) - static_cast<difference_type>(aOther.myOffset);
+        }
+
+        bool operator==(const StreamPosition& aOther) const { return myOffset == aOther.myOffset; }
+
+        size_t Offset() const { return myOffset; }
+
+    private:
+        const MatchSession* mySession = nullptr;
+        size_t myOffset               = 0;
+    };
+
+    // The end of what has been fed so far. Reaching it before Finish marks the session as starved, the step that did
+    // so is undone and retried once more input arrives.
+    class StreamEnd
+    {
+    public:
+        StreamEnd() = default;
+        StreamEnd(MatchSession* aSession) : mySession(aSession) {}
+
+        friend bool operator==(const StreamPosition& aPosition, const StreamEnd& aEnd);
+
+    private:
+        MatchSession* mySession = nullptr;
+    };
+
+    // Recognizes aRoot over input pushed in chunks, keeping the match state between them:
+    //
+    //   MatchSession session = matcher.Stream("value");
+    //   while (read(chunk))
+    //       session.Feed(chunk);
+    //   std::optional<size_t> end = session.Finish();
+    //
+    // Only the bytes a live context may still read are kept, from the lowest position of the context on top of the
+    // stack and the alternatives that have branches left to try. Everything before that is released.
+    class MatchSession
+    {
+    public:
+        MatchSession(const Fragment* aRoot, size_t aMaxDepth = 2'048);
+
+        MatchSession(const MatchSession&)            = delete;
+        MatchSession& operator=(const MatchSession&) = delete;
+
+        MatchSession(MatchSession&&)            = delete;
+        MatchSession& operator=(MatchSession&&) = delete;
+
+        // Matches as far as the input fed so far allows, returns the offset in the stream before which all input has
+        // been released
+        size_t Feed(std::span<const unsigned char> aChunk);
+        size_t Feed(std::string_view aChunk);
+
+        // Ends the input and returns where the match ended as an offset from the start of the stream
+        std::optional<size_t> Finish();
+
+        // Whether the outcome is known without more input
+        bool Done() const { return myContexts.empty(); }
+
+        size_t Released() const { return myReleased; }
+        size_t Retained() const { return myWindow.size(); }
+
+    private:
+        friend class StreamPosition;
+        friend bool operator==(const StreamPosition& aPosition, const StreamEnd& aEnd);
+
+        size_t Available() const { return myReleased + myWindow.size(); }
+
+        void Step();
+        void Release();
+
+        size_t myMaxDepth;
+        bool myFinished = false;
+        bool myStarved  = false;
+
+        std::vector<MatchContext<StreamPosition>> myContexts;
+        Result<StreamPosition> myLastResult;
+        std::optional<size_t> myEnd;
+
+        std::vector<unsigned char> myWindow;
+        size_t myReleased = 0;
+    };
+
+    inline unsigned char StreamPosition::operator*() const { return mySession->myWindow[myOffset - mySession->myReleased]; }
+
+    inline bool operator==(const StreamPosition& aPosition, const StreamEnd& aEnd)
+    {
+        if (aPosition.Offset() != aEnd.mySession->Available())
+            return false;
+
+        if (!aEnd.mySession->myFinished)
+            aEnd.mySession->myStarved = true;
+
+        return true;
+    }
+}  // namespace pattern_matcher
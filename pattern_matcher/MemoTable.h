@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+
+#include "pattern_matcher/Fragment.h"
+
+namespace pattern_matcher
+{
+    enum class MemoPolicy
+    {
+        // No memoization, every fragment is re-run when re-entered
+        None,
+
+        // Every fragment is memoized
+        All,
+
+        // Only fragments marked with Fragment::SetMemoize(true) are memoized
+        Flagged,
+
+        // Every fragment starts out memoized, fragments that are rarely re-entered at the same offset stop being
+        // memoized after a short warm up
+        Adaptive
+    };
+
+    struct MemoCounters
+    {
+        size_t myHits   = 0;
+        size_t myMisses = 0;
+        size_t myStores = 0;
+    };
+
+    // Maps (fragment, offset) to what was produced the last time the fragment was matched at that offset
+    template<class Value>
+    class MemoTable
+    {
+    public:
+        // Amount of lookups a fragment gets before the adaptive policy judges it
+        static constexpr size_t AdaptiveWarmup = 32;
+        // The adaptive policy keeps memoizing fragments that hit at least once every this many lookups
+        static constexpr size_t AdaptiveHitInterval = 8;
+
+        MemoTable(MemoPolicy aPolicy) : myPolicy(aPolicy) {}
+
+        bool Enabled() const { return myPolicy != MemoPolicy::None; }
+
+        bool ShouldMemoize(const Fragment* aFragment)
+        {
+            switch (myPolicy)
+            {
+                case MemoPolicy::None:
+                    return false;
+                case MemoPolicy::All:
+                    return true;
+                case MemoPolicy::Flagged:
+                    return aFragment->IsMemoized();
+                case MemoPolicy::Adaptive: {
+                    auto it = myRates.find(aFragment);
+                    return it == myRates.end() || !it->second.myDisabled;
+                }
+            }
+
+            std::unreachable();
+        }
+
+        // Entries aUsable turns down count as misses, the fragment is run again and its result replaces them
+        template<class Usable>
+        const Value* Lookup(const Fragment* aFragment, size_t aOffset, Usable&& aUsable)
+        {
+            if (!ShouldMemoize(aFragment))
+                return nullptr;
+
+            auto it = myEntries.find(Key{aFragment, aOffset});
+            bool hit = it != myEntries.end() && aUsable(it->second);
+
+            if (hit)
+                myCounters.myHits++;
+            else
+                myCounters.myMisses++;
+
+            if (myPolicy == MemoPolicy::Adaptive)
+            {
+                Rate& rate = myRates[aFragment];
+                rate.myLookups++;
+                if (hit)
+                    rate.myHits++;
+
+                if (rate.myLookups >= AdaptiveWarmup && rate.myHits * AdaptiveHitInterval < rate.myLookups)
+                    rate.myDisabled = true;
+            }
+
+            return hit ? &it->second : nullptr;
+        }
+
+        void Store(const Fragment* aFragment, size_t aOffset, Value aValue)
+        {
+            if (!ShouldMemoize(aFragment))
+                return;
+
+            myEntries.insert_or_assign(Key{aFragment, aOffset}, std::move(aValue));
+            myCounters.myStores++;
+        }
+
+        const MemoCounters& Counters() const { return myCounters; }
+
+    private:
+        struct Key
+        {
+            const Fragment* myFragment;
+            size_t myOffset;
+
+            bool operator==(const Key&) const = default;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& aKey) const
+            {
+                return std::hash<const Fragment*>{}(aKey.myFragment) ^ (aKey.myOffset * 0x9E3779B97F4A7C15ull);
+            }
+        };
+
+        struct Rate
+        {
+            size_t myLookups = 0;
+            size_t myHits    = 0;
+            bool myDisabled  = false;
+        };
+
+        MemoPolicy myPolicy;
+        MemoCounters myCounters;
+        std::unordered_map<Key, Value, KeyHash> myEntries;
+        std::unordered_map<const Fragment*, Rate> myRates;
+    };
+}  // namespace pattern_matcher
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <string_view>
+#include <vector>
+
+#include "pattern_matcher/Concepts.h"
+#include "pattern_matcher/PatternMatchingTypes.h"
+
+namespace pattern_matcher
+{
+    template<class Iterator, class Core>
+    class FlatTreeBuilder;
+
+    // A match result stored as a flat array of nodes in preorder. Each node knows the size of its subtree, so the
+    // children of a node follow it directly and siblings are found by skipping subtrees. Clearing the tree keeps its
+    // storage, so a tree reused between matches stops allocating once it has grown to fit.
+    template<class Iterator>
+        requires std::random_access_iterator<Iterator>
+    class ParseTree
+    {
+    public:
+        struct Node
+        {
+            const Fragment* myFragment;
+
+            // Offsets from the beginning of the matched input
+            size_t myBegin;
+            size_t myEnd;
+
+            // Amount of nodes in the subtree rooted in this node, including itself
+            std::uint32_t mySize;
+        };
+
+        using SearchMode = typename Success<Iterator>::SearchMode;
+
+        class NodeRange;
+
+        // A lightweight handle to a node, mirrors the queries of Success
+        class NodeRef
+        {
+        public:
+            NodeRef(const ParseTree* aTree, size_t aIndex) : myTree(aTree), myIndex(aIndex) {}
+
+            const Node& Get() const { return myTree->myNodes[myIndex]; }
+            size_t Index() const { return myIndex; }
+
+            const Fragment* GetFragment() const { return Get().myFragment; }
+
+            Iterator begin() const { return myTree->myBegin + Get().myBegin; }
+            Iterator end() const { return myTree->myBegin + Get().myEnd; }
+
+            size_t ChildCount() const { return static_cast<size_t>(std::ranges::distance(Children())); }
+
+            NodeRange Children() const
+            {
+                return NodeRange(myTree, myIndex + 1, myIndex + Get().mySize, nullptr, SearchMode::TopLevelOnly);
+            }
+
+            NodeRef operator[](int aIndex) const
+            {
+                size_t at = myIndex + 1;
+
+                for (int i = 0; i < aIndex; i++) at += myTree->myNodes[at].mySize;
+
+                return NodeRef(myTree, at);
+            }
+
+            std::optional<NodeRef> Find(const Fragment* aFragment) const
+            {
+                size_t end = myIndex + Get().mySize;
+
+                for (size_t at = myIndex + 1; at < end; at++)
+                    if (myTree->myNodes[at].myFragment == aFragment)
+                        return NodeRef(myTree, at);
+
+                return {};
+            }
+
+            std::optional<NodeRef> Find(const std::vector<const Fragment*>& aFragments) const
+            {
+                size_t end = myIndex + Get().mySize;
+
+                for (size_t at = myIndex + 1; at < end; at++)
+                    if (std::find(std::begin(aFragments), std::end(aFragments), myTree->myNodes[at].myFragment)
+                        != std::end(aFragments))
+                        return NodeRef(myTree, at);
+
+                return {};
+            }
+
+            NodeRange SearchFor(const Fragment* aFragment, SearchMode aMode = SearchMode::Recursive) const
+            {
+                return NodeRange(myTree, myIndex + 1, myIndex + Get().mySize, aFragment, aMode);
+            }
+
+            bool operator==(const char* aString) const { return *this == std::string_view(aString); }
+
+            template<RangeComparable<std::iter_value_t<Iterator>> Range>
+            bool operator==(Range&& aRange) const
+            {
+                return std::ranges::equal(begin(), end(), std::ranges::begin(aRange), std::ranges::end(aRange));
+            }
+
+        private:
+            const ParseTree* myTree;
+            size_t myIndex;
+        };
+
+        // The nodes of a subtree that are made by a fragment, or all of them when it is null, walked in preorder. The
+        // mode says whether to look inside the nodes found, and inside the ones passed over, the same as in SearchFor
+        // of Success. Children are the nodes found at the top level with no fragment given.
+        class NodeRange
+        {
+        public:
+            class Cursor
+            {
+            public:
+                using value_type      = NodeRef;
+                using difference_type = std::ptrdiff_t;
+
+                Cursor() = default;
+                Cursor(const NodeRange& aRange, size_t aAt)
+                    : myTree(aRange.myTree)
+                    , myAt(aAt)
+                    , myEnd(aRange.myEnd)
+                    , myFragment(aRange.myFragment)
+                    , myMode(aRange.myMode)
+                {
+                    Seek();
+                }
+
+                NodeRef operator*() const { return NodeRef(myTree, myAt); }
+                Cursor& operator++()
+                {
+                    myAt += myMode == SearchMode::All ? 1 : myTree->myNodes[myAt].mySize;
+                    Seek();
+                    return *this;
+                }
+                Cursor operator++(int)
+                {
+                    Cursor out = *this;
+                    ++*this;
+                    return out;
+                }
+
+                bool operator==(const Cursor& aOther) const { return myAt == aOther.myAt; }
+
+            private:
+                // Subtrees lie within their parent, so the walk ends exactly at the end of the range
+                void Seek()
+                {
+                    while (myAt < myEnd && myFragment && myTree->myNodes[myAt].myFragment != myFragment)
+                        myAt += myMode == SearchMode::TopLevelOnly ? myTree->myNodes[myAt].mySize : 1;
+                }
+
+                const ParseTree* myTree    = nullptr;
+                size_t myAt                = 0;
+                size_t myEnd               = 0;
+                const Fragment* myFragment = nullptr;
+                SearchMode myMode          = SearchMode::Recursive;
+            };
+
+            NodeRange(const ParseTree* aTree, size_t aBegin, size_t aEnd, const Fragment* aFragment, SearchMode aMode)
+                : myTree(aTree), myBegin(aBegin), myEnd(aEnd), myFragment(aFragment), myMode(aMode)
+            {
+            }
+
+            Cursor begin() const { return Cursor(*this, myBegin); }
+            Cursor end() const { return Cursor(*this, myEnd); }
+
+        private:
+            const ParseTree* myTree;
+            size_t myBegin;
+            size_t myEnd;
+            const Fragment* myFragment;
+            SearchMode myMode;
+        };
+
+        void Clear() { myNodes.clear(); }
+
+        bool Empty() const { return myNodes.empty(); }
+        size_t Size() const { return myNodes.size(); }
+        size_t Capacity() const { return myNodes.capacity(); }
+
+        const std::vector<Node>& Nodes() const { return myNodes; }
+
+        // Only valid on a tree holding a match, check Empty() first
+        NodeRef Root() const
+        {
+            assert(!myNodes.empty());
+            return NodeRef(this, 0);
+        }
+
+        Iterator InputBegin() const { return myBegin; }
+
+    private:
+        template<class, class>
+        friend class FlatTreeBuilder;
+
+        Iterator myBegin;
+        std::vector<Node> myNodes;
+
+        // Indices of the nodes being matched, kept here so a reused tree also reuses this storage
+        std::vector<size_t> myOpen;
+    };
+}  // namespace pattern_matcher
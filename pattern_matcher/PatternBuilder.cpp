@@ -4,7 +4,7 @@
 
 namespace pattern_matcher
 {
-    PatternBuilder::Builder::Builder() : myMode(Mode::Unkown) {}
+    PatternBuilder::Builder::Builder() : myMode(Mode::Unkown), myMemoize(false), myCapture(true) {}
 
     void PatternBuilder::Builder::operator=(std::string aLiteral)
     {
@@ -73,7 +73,34 @@ namespace pattern_matcher
         myParts.push_back(aChars);
     }
 
+    PatternBuilder::Builder& PatternBuilder::Builder::Memoize()
+    {
+        myMemoize = true;
+
+        return *this;
+    }
+
+    PatternBuilder::Builder& PatternBuilder::Builder::Transparent()
+    {
+        myCapture = false;
+
+        return *this;
+    }
+
     std::optional<Fragment> PatternBuilder::Builder::Bake(PatternMatcher<>& aMatcher)
+    {
+        std::optional<Fragment> fragment = BakeFragment(aMatcher);
+
+        if (fragment)
+        {
+            fragment->SetMemoize(myMemoize);
+            fragment->SetCapture(myCapture);
+        }
+
+        return fragment;
+    }
+
+    std::optional<Fragment> PatternBuilder::Builder::BakeFragment(PatternMatcher<>& aMatcher)
     {
         std::vector<const Fragment*> fragments;
 
@@ -106,7 +133,7 @@ namespace pattern_matcher
                 break;
 
             case Mode::Literal:
-                return Fragment(Fragment::Type::Sequence, aMatcher.Of(myParts[0]));
+                return Fragment(myParts[0]);
 
             case Mode::Sequence:
                 return Fragment(Fragment::Type::Sequence, fragments);
@@ -115,9 +142,9 @@ namespace pattern_matcher
                 return Fragment(Fragment::Type::Alternative, fragments);
 
             case Mode::Of:
-                return Fragment(Fragment::Type::Alternative, aMatcher.Of(myParts[0]));
+                return Fragment(CharClass::Of(myParts[0]));
             case Mode::NotOf:
-                return Fragment(Fragment::Type::Alternative, aMatcher.NotOf(myParts[0]));
+                return Fragment(CharClass::NotOf(myParts[0]));
 
             case Mode::Repeat:
                 assert(myParts.size() == 1);
@@ -143,26 +170,29 @@ namespace pattern_matcher
 
     bool PatternBuilder::HasKey(std::string aKey)
     {
-        for (auto [key, builder] : myParts)
-            if (key == aKey)
-                return true;
-
-        return false;
+        return myPartIndices.contains(aKey);
     }
 
     PatternBuilder::Builder& PatternBuilder::operator[](std::string aKey)
     {
-        myParts.push_back({aKey, {}});
-        return myParts[myParts.size() - 1].second;
+        auto [it, inserted] = myPartIndices.try_emplace(aKey, myParts.size());
+        if (inserted)
+            myParts.push_back({aKey, {}});
+
+        return myParts[it->second].second;
     }
 
     PatternMatcher<std::string> PatternBuilder::Finalize()
     {
         PatternMatcher<std::string> matcher;
 
+        // operator[] of the matcher only gives const fragments
+        std::unordered_map<std::string, Fragment*> slots;
+
         for (auto& [key, part] : myParts)
         {
-            matcher.EmplaceFragment(key);
+            Fragment& slot = matcher.EmplaceFragment(key);
+            slots.emplace(key, &slot);
 
             if (part.IsPrimary())
             {
@@ -173,7 +203,7 @@ namespace pattern_matcher
                     continue;
                 }
 
-                *matcher[key] = *fragment;
+                slot = std::move(*fragment);
             }
         }
 
@@ -188,7 +218,7 @@ namespace pattern_matcher
                     continue;
                 }
 
-                *matcher[key] = *fragment;
+                *slots.at(key) = std::move(*fragment);
             }
         }
 
@@ -198,6 +228,9 @@ namespace pattern_matcher
                 fprintf(stderr, "Recursion found in %s", key.c_str());
         }
 
+        matcher.Analyze();
+        matcher.Pack();
+
         return matcher;
     }
 
@@ -206,6 +239,25 @@ namespace pattern_matcher
         return std::string(std::ranges::begin(aSuccess), std::ranges::end(aSuccess));
     }
 
+    // Decodes a single character of a [...] class in bnf
+    char ClassChar(Success<std::ranges::iterator_t<std::string>>& aChar, const Fragment* aEscaped)
+    {
+        if (!aChar.Find(aEscaped))
+            return *aChar.myBegin;
+
+        switch (*(aChar.myEnd - 1))
+        {
+            case 'n':
+                return '\n';
+            case 'r':
+                return '\r';
+            case 't':
+                return '\t';
+            default:
+                return *(aChar.myEnd - 1);
+        }
+    }
+
     PatternMatcher<std::string> PatternBuilder::FromBNF(std::string aBNF)
     {
         PatternBuilder out;
@@ -231,47 +283,88 @@ namespace pattern_matcher
             {
                 std::vector<std::string> sequence;
 
-                for (Success& val : option.SearchFor(metaParser["value-part"]))
+                // The first part of a value has its own fragment as it can't start with a pipe
+                std::vector<Success*> parts{option.Find(metaParser["value-part-first"])};
+                for (Success& val : option.SearchFor(metaParser["value-part"])) parts.push_back(&val);
+
+                for (Success* part : parts)
                 {
+                    Success& val = *part;
                     Success* subFragmentName = val.Find(metaParser["identifier"]);
                     Success* subLiteral = val.Find(metaParser["literal-content"]);
+                    Success* subClass = val.Find(metaParser["class"]);
                     std::string fragment;
                     if (subFragmentName)
                     {
                         fragment = ToString(*subFragmentName);
-                        Success* modifier    = val.Find(metaParser["repeat-char"]);
+                    }
+                    else if (subLiteral)
+                    {
+                        std::string literalString = ToString(*subLiteral);
+                        fragment   = "literal-" + literalString;
 
-                        if (modifier)
-                        {
-                            Builder::Repeat repeat;
-                            repeat.myBase = fragment;
+                        if (!out.HasKey(fragment))
+                            out[fragment] = literalString;
+                    }
+                    else if (subClass)
+                    {
+                        fragment = "class-" + ToString(*subClass);
 
-                            switch (*modifier->begin())
+                        if (!out.HasKey(fragment))
+                        {
+                            std::string chars;
+                            for (Success& item : subClass->SearchFor(metaParser["class-item"]))
                             {
-                                case '*':
-                                    fragment += "-any";
-                                    repeat.myCount = {0, RepeatCount::Unbounded};
-                                    break;
-                                case '+':
-                                    fragment += "-repeated";
-                                    repeat.myCount = {1, RepeatCount::Unbounded};
-                                    break;
-                                case '?':
-                                    fragment += "-optional";
-                                    repeat.myCount = {0, 1};
-                                    break;
+                                std::vector<char> ends;
+                                for (Success& end : item.SearchFor(metaParser["class-char"]))
+                                    ends.push_back(ClassChar(end, metaParser["class-escaped"]));
+
+                                // A reversed range would silently match nothing
+                                if (static_cast<unsigned char>(ends.front()) > static_cast<unsigned char>(ends.back()))
+                                {
+                                    fprintf(stderr, "Reversed range %s in class of %s\n", ToString(item).c_str(),
+                                            key.c_str());
+                                    return PatternBuilder().Finalize();
+                                }
+
+                                for (int c = static_cast<unsigned char>(ends.front());
+                                     c <= static_cast<unsigned char>(ends.back()); c++)
+                                    chars += static_cast<char>(c);
                             }
-                            if (!out.HasKey(fragment))
-                                out[fragment] = repeat;
+
+                            if (subClass->Find(metaParser["class-negate"]))
+                                out[fragment].NotOf(chars);
+                            else
+                                out[fragment].OneOf(chars);
                         }
                     }
-                    else if (subLiteral)
+
+                    if (Success* modifier = val.Find(metaParser["repeat-char"]))
                     {
-                        std::string literalString = ToString(*subLiteral);
-                        fragment   = "literal-" + literalString;
+                        Builder::Repeat repeat;
+                        repeat.myBase = fragment;
 
+                        switch (*modifier->begin())
+                        {
+                            case '*':
+                                fragment += "-any";
+                                repeat.myCount = {0, RepeatCount::Unbounded};
+                                break;
+                            case '+':
+                                fragment += "-repeated";
+                                repeat.myCount = {1, RepeatCount::Unbounded};
+                                break;
+                            case '?':
+                                fragment += "-optional";
+                                repeat.myCount = {0, 1};
+                                break;
+                        }
                         if (!out.HasKey(fragment))
-                            out[fragment] = literalString;
+                        {
+                            if (fragment.starts_with('_'))
+                                out[fragment].Transparent();
+                            out[fragment] = repeat;
+                        }
                     }
 
                     if (sequence.size() > 0)
@@ -284,6 +377,10 @@ namespace pattern_matcher
                 options.push_back(sequence);
             }
 
+            // Declarations starting with an underscore are spliced into their parent, same as in lark
+            if (key.starts_with('_'))
+                out[key].Transparent();
+
             if (options.size() == 1)
             {
                 out[key] && options[0];
@@ -294,6 +391,8 @@ namespace pattern_matcher
                 for (size_t i = 0; i < options.size(); i++)
                 {
                     std::string subKey = key + "-" + std::to_string(i);
+                    if (key.starts_with('_'))
+                        out[subKey].Transparent();
                     out[subKey] && options[i];
                     subKeys.push_back(subKey);
                 }
@@ -320,7 +419,7 @@ namespace pattern_matcher
         switch (aNode->GetType())
         {
             case Fragment::Type::Alternative:
-                return aNode->SubFragments();
+                return std::vector<const Fragment*>(aNode->SubFragments().begin(), aNode->SubFragments().end());
             case Fragment::Type::Sequence:
             case Fragment::Type::Repeat:
                 if (aNode->SubFragments().size() == 0)
@@ -358,7 +457,7 @@ namespace pattern_matcher
     {
         PatternBuilder builder;
 
-        builder["identifier-char"].OneOf("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-");
+        builder["identifier-char"].OneOf("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_");
         builder["literal-char"].NotOf("\" \t\n\r");
         builder["repeat-char"].OneOf("+*?");
         builder["comment-initializer"] = "#";
@@ -379,7 +478,22 @@ namespace pattern_matcher
         builder["literal-content"] = {"literal-char", {1, RepeatCount::Unbounded}};
         builder["literal"] && "quote" && "literal-content" && "quote";
 
-        builder["value-subpart"] || "literal" || "identifier";
+        builder["class-open"]            = "[";
+        builder["class-close"]           = "]";
+        builder["class-negate"]          = "^";
+        builder["class-negate-optional"] = {"class-negate", {0, 1}};
+        builder["class-dash"]            = "-";
+        builder["class-backslash"]       = "\\";
+        builder["class-plain"].NotOf("]\\\n");
+        builder["class-escape-char"].NotOf("\n");
+        builder["class-escaped"] && "class-backslash" && "class-escape-char";
+        builder["class-char"] || "class-escaped" || "class-plain";
+        builder["class-range"] && "class-char" && "class-dash" && "class-char";
+        builder["class-item"] || "class-range" || "class-char";
+        builder["class-items"] = {"class-item", {1, RepeatCount::Unbounded}};
+        builder["class"] && "class-open" && "class-negate-optional" && "class-items" && "class-close";
+
+        builder["value-subpart"] || "literal" || "identifier" || "class";
 
         builder["identifier-pipe"] && "pipe" && "whitespace-optional";
         builder["identifier-pipe-optional"] = {"identifier-pipe", {0, 1}};
@@ -4,6 +4,7 @@
 #include <string>
 #include <unordered_map>
 
+#include "pattern_matcher/CompiledGrammar.h"
 #include "pattern_matcher/PatternMatcher.h"
 #include "pattern_matcher/RepeatCount.h"
 
@@ -33,6 +34,13 @@ namespace pattern_matcher
             void NotOf(std::string aChars);
             void OneOf(std::string aChars);
 
+            // Marks the fragment for memoization under MemoPolicy::Flagged
+            Builder& Memoize();
+
+            // Splices the children of the fragment into its parent instead of producing a node, see
+            // Fragment::SetCapture
+            Builder& Transparent();
+
             std::optional<pattern_matcher::Fragment> Bake(PatternMatcher<>& Patterns);
 
             bool IsPrimary();
@@ -49,12 +57,17 @@ namespace pattern_matcher
                 Repeat
             };
 
+            std::optional<pattern_matcher::Fragment> BakeFragment(PatternMatcher<>& Patterns);
+
             RepeatCount myCount;
             Mode myMode;
+            bool myMemoize;
+            bool myCapture;
             std::vector<std::string> myParts;
         };
 
         bool HasKey(std::string aKey);
+        // The builder of aKey, added empty the first time a key is used
         Builder& operator[](std::string aKey);
 
         PatternMatcher<std::string> Finalize();
@@ -71,5 +84,8 @@ namespace pattern_matcher
         bool CheckForRecursion(const Fragment* aCurrent, const Fragment* aRoot);
 
         std::vector<std::pair<std::string, Builder>> myParts;
+
+        // Position of each key in myParts, so looking up a key does not scan every part
+        std::unordered_map<std::string, size_t> myPartIndices;
     };
 }  // namespace pattern_matcher
\ No newline at end of file
@@ -5,7 +5,7 @@ namespace pattern_matcher
 {
     PatternMatcherLiterals::PatternMatcherLiterals() 
     {
-        for (size_t i = 0; i < std::numeric_limits<Fragment::Literal>::max(); i++) 
+        for (size_t i = 0; i < size; i++) 
             ourLiterals[i] = i;
     }
 
@@ -1,18 +1,34 @@
 #pragma once
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <optional>
 #include <ranges>
-#include <stack>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "pattern_matcher/Analysis.h"
+#include "pattern_matcher/Batch.h"
 #include "pattern_matcher/Fragment.h"
+#include "pattern_matcher/FragmentPool.h"
+#include "pattern_matcher/Jit.h"
+#include "pattern_matcher/MappedFile.h"
+#include "pattern_matcher/MatchBuilders.h"
+#include "pattern_matcher/MatchSession.h"
+#include "pattern_matcher/MemoTable.h"
+#include "pattern_matcher/ParseTree.h"
+#include "pattern_matcher/Profile.h"
+#include "pattern_matcher/Program.h"
+#include "pattern_matcher/Simd.h"
 
 namespace pattern_matcher
 {
     struct PatternMatcherLiterals
     {
-        static constexpr size_t size = std::numeric_limits<Fragment::Literal>::max();
+        static constexpr size_t size = std::numeric_limits<Fragment::Literal>::max() + 1;
 
         PatternMatcherLiterals();
 
@@ -26,6 +42,18 @@ namespace pattern_matcher
     };
 
 
+    enum class SearchMode
+    {
+        // Continues after the end of each match, an empty match moves on by one
+        NonOverlapping,
+
+        // Tries every start position, so matches may overlap
+        All
+    };
+
+    template<class Key>
+    class CompiledGrammar;
+
     template<class Key = std::string>
     class PatternMatcher
     {
@@ -37,9 +65,12 @@ namespace pattern_matcher
         PatternMatcher(PatternMatcher&&)            = default;
         PatternMatcher& operator=(PatternMatcher&&) = default;
 
+        // Only while building, before Pack, as the packed fragments are copies that would not see the new one
         template<class... T>
         Fragment& EmplaceFragment(Key aKey, T&&... aArgs)
         {
+            assert(!IsPacked());
+
             auto insertionResult = myFragments.emplace(std::piecewise_construct, std::forward_as_tuple(aKey),
                                                        std::forward_as_tuple(aArgs...));
 
@@ -48,16 +79,53 @@ namespace pattern_matcher
             return insertionResult.first->second;
         }
 
-        Fragment* operator[](Key aKey)
+        // Once packed these give the fragments in the pool
+        const Fragment* operator[](Key aKey) const
         {
             auto it = myFragments.find(aKey);
             if (it == myFragments.end())
                 return nullptr;
 
+            if (const Fragment* packed = myPool.Find(&it->second))
+                return packed;
+
             return &it->second;
         }
 
-        const Fragment* operator[](Fragment::Literal aLiteral) { return ourLiterals[aLiteral]; }
+        const Fragment* operator[](Fragment::Literal aLiteral) const
+        {
+            if (const Fragment* packed = myPool.Find(ourLiterals[aLiteral]))
+                return packed;
+
+            return ourLiterals[aLiteral];
+        }
+
+        // Copies every fragment into one contiguous FragmentPool that following matches run on
+        void Pack()
+        {
+            std::vector<const Fragment*> roots;
+            roots.reserve(myFragments.size());
+
+            for (auto& [key, fragment] : myFragments) roots.push_back(&fragment);
+
+            myPool = FragmentPool(roots);
+        }
+
+        // Moves the fragments into an immutable CompiledGrammar that can be shared between threads, packing them first
+        // if needed. Leaves this matcher empty.
+        std::shared_ptr<const CompiledGrammar<Key>> Freeze() &&
+        {
+            if (!IsPacked())
+            {
+                Analyze();
+                Pack();
+            }
+
+            return std::make_shared<const CompiledGrammar<Key>>(std::move(*this));
+        }
+
+        bool IsPacked() const { return !myPool.Empty(); }
+        const FragmentPool& Pool() const { return myPool; }
 
         std::vector<const Fragment*> Of(std::string aList)
         {
@@ -71,20 +139,16 @@ namespace pattern_matcher
         std::vector<const Fragment*> NotOf(std::string aList)
         {
             std::vector<const Fragment*> out;
-            Fragment::Literal i = std::numeric_limits<Fragment::Literal>::min();
-            do
-            {
-                if (aList.find(i) == std::string::npos)
-                    out.push_back(ourLiterals[i]);
 
-                i++;
-            } while (i < std::numeric_limits<Fragment::Literal>::max());
+            for (size_t i = 0; i < PatternMatcherLiterals::size; i++)
+                if (aList.find(static_cast<char>(i)) == std::string::npos)
+                    out.push_back(ourLiterals[static_cast<Fragment::Literal>(i)]);
 
             return out;
         }
 
         template<class Iterator, class Sentinel>
-        void DebugDump(std::stack<MatchContext<Iterator>> aStack, Sentinel aEnd)
+        void DebugDump(const std::vector<MatchContext<Iterator>>& aStack, Sentinel aEnd) const
         {
             const int height = 8;
             const int width  = 120;  // does not include name of the fragments
@@ -92,15 +156,7 @@ namespace pattern_matcher
             if (aStack.empty())
                 throw "No Contexts Supplied";
 
-            std::stack<MatchContext<Iterator>> copy(aStack);
-            std::vector<MatchContext<Iterator>> deStacked;
-
-            while (!copy.empty())
-            {
-                deStacked.push_back(copy.top());
-                copy.pop();
-            }
-            std::reverse(std::begin(deStacked), std::end(deStacked));
+            std::vector<MatchContext<Iterator>> deStacked(aStack);
             std::vector<std::string> lines;
             lines.resize(deStacked.size());
 
@@ -118,34 +174,11 @@ namespace pattern_matcher
 
                 for (; index < lines.size(); index++)
                 {
-                    const Fragment* fragment = deStacked[index].myFragment;
-                    std::string name         = "<external>";
-
-                    if (fragment->GetType() == Fragment::Type::Literal)
-                    {
-                        if (ourLiterals.Contains(fragment))
-                            name = "Literal " + std::to_string(ourLiterals.ValueOf(fragment));
-
-                    } else
-                    {
-                        for (auto& kvPair : myFragments)
-                        {
-                            if (&kvPair.second == fragment)
-                            {
-                                name = kvPair.first;
-                                break;
-                            }
-                        }
-                    }
+                    std::string name = NameOf(deStacked[index].myFragment);
 
-                    fprintf(stderr, "%s %3i: %s[%i]", lines[index].c_str(), index, name.c_str(),
+                    fprintf(stderr, "%s %3i: %s[%i]\n", lines[index].c_str(), index, name.c_str(),
                             deStacked[index].myIndex);
 
-                    if (deStacked[index].mySubMatches.size() > 0)
-                        fprintf(stderr, " (matches so far: %i)\n", (int)deStacked[index].mySubMatches.size());
-                    else
-                        fprintf(stderr, "\n");
-
                     lines[index] = "";
                 }
 
@@ -217,7 +250,7 @@ namespace pattern_matcher
         }
 
         template<class Iterator>
-        void DebugDump(Result<Iterator> aRes)
+        void DebugDump(const Result<Iterator>& aRes) const
         {
             switch (aRes.GetType())
             {
@@ -257,23 +290,822 @@ namespace pattern_matcher
         std::optional<Success<Iterator>> Match(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd,
                                                size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296)
         {
+            auto [begin, end] = Lower(aBegin, aEnd);
+            TreeBuilder<Iterator, decltype(begin)> builder({aBegin, begin});
+
+            if (!Run(aRoot, begin, end, builder, aMaxDepth, aMaxSteps))
+                return {};
+
+            return builder.Result();
+        }
+
+        // Matches into a flat ParseTree instead of a tree of Success, reusing the storage of aOut
+        template<std::ranges::random_access_range Range>
+        bool Match(Key aRoot, Range& aRange, ParseTree<std::ranges::iterator_t<Range>>& aOut,
+                   size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296)
+        {
+            return Match(this->operator[](aRoot), std::ranges::begin(aRange), std::ranges::end(aRange), aOut,
+                         aMaxDepth, aMaxSteps);
+        }
+
+        template<std::ranges::random_access_range Range>
+        bool Match(const Fragment* aRoot, Range& aRange, ParseTree<std::ranges::iterator_t<Range>>& aOut,
+                   size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296)
+        {
+            return Match(aRoot, std::ranges::begin(aRange), std::ranges::end(aRange), aOut, aMaxDepth, aMaxSteps);
+        }
+
+        template<std::random_access_iterator Iterator, class Sentinel>
+        bool Match(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd, ParseTree<Iterator>& aOut,
+                   size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296)
+        {
+            auto [begin, end] = Lower(aBegin, aEnd);
+            FlatTreeBuilder<Iterator, decltype(begin)> builder(aOut, aBegin, begin);
+
+            if (Run(aRoot, begin, end, builder, aMaxDepth, aMaxSteps))
+                return true;
+
+            aOut.Clear();
+            return false;
+        }
+
+        std::optional<Success<const char*>> Match(Key aRoot, const char* aRange, size_t aMaxDepth = 2'048,
+                                                  size_t aMaxSteps = 4'294'967'296)
+        {
+            return Match(this->operator[](aRoot), aRange, aRange + ::strlen(aRange), aMaxDepth, aMaxSteps);
+        }
+
+        // Maps the file at aPath and matches over the mapping without copying it, the result keeps the mapping alive.
+        // Empty if the file can not be opened or does not match.
+        std::optional<FileMatch> MatchFile(Key aRoot, const std::filesystem::path& aPath, size_t aMaxDepth = 2'048,
+                                           size_t aMaxSteps = 4'294'967'296)
+        {
+            return MatchFile(this->operator[](aRoot), aPath, aMaxDepth, aMaxSteps);
+        }
+
+        std::optional<FileMatch> MatchFile(const Fragment* aRoot, const std::filesystem::path& aPath,
+                                           size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296)
+        {
+            std::shared_ptr<const MappedFile> file = MappedFile::Open(aPath);
+            if (!file)
+                return {};
+
+            std::optional<Success<const char*>> result = Match(aRoot, file->begin(), file->end(), aMaxDepth, aMaxSteps);
+            if (!result)
+                return {};
+
+            return FileMatch{std::move(file), std::move(*result)};
+        }
+
+        // Runs the same matching as Match without building any result, returns where the match ended
+        template<std::ranges::range Range>
+        std::optional<std::ranges::iterator_t<Range>> Recognize(Key aRoot, Range& aRange, size_t aMaxDepth = 2'048,
+                                                                size_t aMaxSteps = 4'294'967'296)
+        {
+            return Recognize(this->operator[](aRoot), std::ranges::begin(aRange), std::ranges::end(aRange), aMaxDepth,
+                             aMaxSteps);
+        }
+
+        template<std::ranges::range Range>
+        std::optional<std::ranges::iterator_t<Range>> Recognize(const Fragment* aRoot, Range& aRange,
+                                                                size_t aMaxDepth = 2'048,
+                                                                size_t aMaxSteps = 4'294'967'296)
+        {
+            return Recognize(aRoot, std::ranges::begin(aRange), std::ranges::end(aRange), aMaxDepth, aMaxSteps);
+        }
+
+        template<class Iterator, class Sentinel>
+        std::optional<Iterator> Recognize(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd,
+                                          size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296)
+        {
+            auto [begin, end] = Lower(aBegin, aEnd);
+            RecognizeBuilder<Iterator, decltype(begin)> builder({aBegin, begin});
+
+            if (!Run(aRoot, begin, end, builder, aMaxDepth, aMaxSteps))
+                return {};
+
+            return builder.Result();
+        }
+
+        std::optional<const char*> Recognize(Key aRoot, const char* aRange, size_t aMaxDepth = 2'048,
+                                             size_t aMaxSteps = 4'294'967'296)
+        {
+            return Recognize(this->operator[](aRoot), aRange, aRange + ::strlen(aRange), aMaxDepth, aMaxSteps);
+        }
+
+        // Matches every input in aInputs against aRoot, spread over worker threads, see ForEachParallel. Results are in
+        // the order of aInputs. Workers share the fragments and keep their context stack and builder between inputs.
+        template<std::ranges::random_access_range Inputs>
+        std::vector<std::optional<Success<BatchIterator<Inputs>>>> MatchMany(Key aRoot, Inputs& aInputs,
+                                                                             const BatchOptions& aOptions = {})
+        {
+            return MatchMany(this->operator[](aRoot), aInputs, aOptions);
+        }
+
+        template<std::ranges::random_access_range Inputs>
+        std::vector<std::optional<Success<BatchIterator<Inputs>>>> MatchMany(const Fragment* aRoot, Inputs& aInputs,
+                                                                             const BatchOptions& aOptions = {}) const
+        {
+            std::vector<std::optional<Success<BatchIterator<Inputs>>>> out;
+            RunMany<TreeBuilder>(aRoot, aInputs, aOptions, out);
+            return out;
+        }
+
+        // As MatchMany without building any results, gives where each match ended
+        template<std::ranges::random_access_range Inputs>
+        std::vector<std::optional<BatchIterator<Inputs>>> RecognizeMany(Key aRoot, Inputs& aInputs,
+                                                                        const BatchOptions& aOptions = {})
+        {
+            return RecognizeMany(this->operator[](aRoot), aInputs, aOptions);
+        }
+
+        template<std::ranges::random_access_range Inputs>
+        std::vector<std::optional<BatchIterator<Inputs>>> RecognizeMany(const Fragment* aRoot, Inputs& aInputs,
+                                                                        const BatchOptions& aOptions = {}) const
+        {
+            std::vector<std::optional<BatchIterator<Inputs>>> out;
+            RunMany<RecognizeBuilder>(aRoot, aInputs, aOptions, out);
+            return out;
+        }
+
+        // The first match of aRoot starting anywhere in the input, see FindAll
+        template<std::ranges::range Range>
+        std::optional<Success<std::ranges::iterator_t<Range>>> Search(Key aRoot, Range& aRange,
+                                                                      size_t aMaxDepth = 2'048,
+                                                                      size_t aMaxSteps = 4'294'967'296)
+        {
+            return Search(this->operator[](aRoot), std::ranges::begin(aRange), std::ranges::end(aRange), aMaxDepth,
+                          aMaxSteps);
+        }
+
+        template<class Iterator, class Sentinel>
+        std::optional<Success<Iterator>> Search(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd,
+                                                size_t aMaxDepth = 2'048, size_t aMaxSteps = 4'294'967'296) const
+        {
+            for (Success<Iterator>&& match : FindAll(aRoot, aBegin, aEnd, SearchMode::NonOverlapping, aMaxDepth,
+                                                     aMaxSteps))
+                return std::move(match);
+
+            return {};
+        }
+
+        // The matches of FindAll, found one at a time as the range is iterated. The context stack and tree builder are
+        // reused from one start position to the next. Like the input it reads, it can only be iterated once.
+        template<class Iterator, class Sentinel>
+        class Matches
+        {
+            using Lowered = decltype(Lower(std::declval<Iterator>(), std::declval<Sentinel>()));
+            using Core    = typename Lowered::first_type;
+
+        public:
+            class Cursor
+            {
+            public:
+                using value_type      = Success<Iterator>;
+                using difference_type = std::ptrdiff_t;
+
+                Cursor() = default;
+                explicit Cursor(Matches* aMatches) : myMatches(aMatches) {}
+
+                Success<Iterator>&& operator*() const { return std::move(*myMatches->myCurrent); }
+                Cursor& operator++()
+                {
+                    myMatches->Advance();
+                    return *this;
+                }
+                void operator++(int) { ++*this; }
+
+                bool operator==(std::default_sentinel_t) const { return !myMatches->myCurrent; }
+
+            private:
+                Matches* myMatches = nullptr;
+            };
+
+            Matches(const PatternMatcher& aMatcher, const Fragment* aRoot, Iterator aBegin, Sentinel aEnd,
+                    SearchMode aMode, size_t aMaxDepth, size_t aMaxSteps)
+                : myMatcher(aMatcher)
+                , myRoot(aRoot)
+                , myMode(aMode)
+                , myMaxDepth(aMaxDepth)
+                , myMaxSteps(aMaxSteps)
+                , myBegin(aBegin)
+                , myLowered(Lower(aBegin, aEnd))
+                , myAt(myLowered.first)
+                , myAnywhere(!aRoot->IsAnalyzed() || aRoot->IsNullable())
+                , myBuilder({aBegin, myLowered.first})
+            {
+                if constexpr (std::is_pointer_v<Core>)
+                    if (!myAnywhere)
+                        myFinder.emplace(aRoot->First());
+            }
+
+            // Cursors point back here
+            Matches(const Matches&)            = delete;
+            Matches& operator=(const Matches&) = delete;
+
+            Cursor begin()
+            {
+                Advance();
+                return Cursor(this);
+            }
+            std::default_sentinel_t end() const { return std::default_sentinel; }
+
+        private:
+            void Advance()
+            {
+                if (myCurrent)
+                {
+                    bool skip = myMode == SearchMode::NonOverlapping && myMatchEnd != myAt;
+                    myCurrent.reset();
+
+                    if (skip)
+                        myAt = myMatchEnd;
+                    else if (!Step())
+                        return;
+                }
+
+                auto& [begin, end] = myLowered;
+                while (true)
+                {
+                    if (!myAnywhere)
+                    {
+                        if constexpr (std::is_pointer_v<Core>)
+                            myAt = (*myFinder)(myAt, end);
+                        else
+                            while (myAt != end && !myRoot->First().Contains(static_cast<Fragment::Literal>(*myAt)))
+                                ++myAt;
+
+                        if (myAt == end)
+                            return;
+                    }
+
+                    myBuilder.Reset({myBegin, begin});
+
+                    if (myMatcher.Run(myRoot, myAt, end, myBuilder, myMaxDepth, myMaxSteps, myContexts, myCounters))
+                    {
+                        myCurrent = myBuilder.Result();
+
+                        if constexpr (std::is_same_v<Core, Iterator>)
+                            myMatchEnd = myCurrent->myEnd;
+                        else
+                            myMatchEnd = begin + (myCurrent->myEnd - myBegin);
+                        return;
+                    }
+
+                    if (!Step())
+                        return;
+                }
+            }
+
+            bool Step()
+            {
+                if (myAt == myLowered.second)
+                    return false;
+
+                ++myAt;
+                return true;
+            }
+
+            const PatternMatcher& myMatcher;
+            const Fragment* myRoot;
+            SearchMode myMode;
+            size_t myMaxDepth;
+            size_t myMaxSteps;
+            Iterator myBegin;
+            Lowered myLowered;
+            Core myAt;
+            Core myMatchEnd{};
+            bool myAnywhere;
+            std::optional<simd::ByteFinder> myFinder;
+            std::vector<MatchContext<Core>> myContexts;
+            MemoCounters myCounters;
+            TreeBuilder<Iterator, Core> myBuilder;
+            std::optional<Success<Iterator>> myCurrent;
+        };
+
+        // Every match of aRoot in the input, in order of where they start. Only positions where the root can start, as
+        // given by its FIRST set, are tried and contiguous byte input jumps between them with simd::ByteFinder. Roots
+        // that can match empty, or have not been analyzed, are tried at every position.
+        template<std::ranges::range Range>
+        Matches<std::ranges::iterator_t<Range>, std::ranges::sentinel_t<Range>> FindAll(
+            Key aRoot, Range& aRange, SearchMode aMode = SearchMode::NonOverlapping, size_t aMaxDepth = 2'048,
+            size_t aMaxSteps = 4'294'967'296)
+        {
+            return FindAll(this->operator[](aRoot), std::ranges::begin(aRange), std::ranges::end(aRange), aMode,
+                           aMaxDepth, aMaxSteps);
+        }
+
+        template<class Iterator, class Sentinel>
+        Matches<Iterator, Sentinel> FindAll(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd,
+                                            SearchMode aMode = SearchMode::NonOverlapping, size_t aMaxDepth = 2'048,
+                                            size_t aMaxSteps = 4'294'967'296) const
+        {
+            return Matches<Iterator, Sentinel>(*this, aRoot, aBegin, aEnd, aMode, aMaxDepth, aMaxSteps);
+        }
+
+        // Matches a Repeat root over one large input on several threads, giving the same result as Match. The input is
+        // cut into chunks and each chunk after the first starts at the first match of aSync from its cut, a guess at
+        // where an item starts. Every chunk is matched item by item, in parallel, until it passes the start of the
+        // next. The chunks are then stitched in order. A chunk that starts exactly where the items so far end is used
+        // as is, since an item matches the same no matter what came before it. A chunk that starts inside an item was a
+        // wrong guess and is thrown away, items are then matched one at a time until the next chunk lines up.
+        // Repeats of items that can match empty are matched sequentially. The steps of the items that were used count
+        // against SplitOptions::myMaxSteps together, as they would in Match, work thrown away does not. How the input
+        // was split is written to aCounters when given.
+        template<std::ranges::random_access_range Range>
+        std::optional<Success<std::ranges::iterator_t<Range>>> MatchParallel(Key aRoot, Key aSync, Range& aRange,
+                                                                             const SplitOptions& aOptions = {},
+                                                                             SplitCounters* aCounters = nullptr) const
+        {
+            return MatchParallel(this->operator[](aRoot), this->operator[](aSync), std::ranges::begin(aRange),
+                                 std::ranges::end(aRange), aOptions, aCounters);
+        }
+
+        template<std::random_access_iterator Iterator, std::sized_sentinel_for<Iterator> Sentinel>
+        std::optional<Success<Iterator>> MatchParallel(const Fragment* aRoot, const Fragment* aSync, Iterator aBegin,
+                                                       Sentinel aEnd, const SplitOptions& aOptions = {},
+                                                       SplitCounters* aCounters = nullptr) const
+        {
+            assert(aRoot->GetType() == Fragment::Type::Repeat);
+
+            auto [begin, end] = Lower(aBegin, aEnd);
+            using Core        = decltype(begin);
+
+            size_t size    = static_cast<size_t>(end - begin);
+            size_t threads = aOptions.myThreads ? aOptions.myThreads : std::max(std::thread::hardware_concurrency(), 1u);
+            size_t chunks  = std::min(threads, size / std::max<size_t>(aOptions.myMinChunkSize, 1));
+
+            SplitCounters unused;
+            SplitCounters& counters = aCounters ? *aCounters : unused;
+            counters                = {};
+
+            const Fragment* item = aRoot->Child(0);
+
+            // A sequential match repeats an item that matched empty until the maximum, chunks can't
+            if (chunks < 2 || aRoot->IsSpan() || !item->IsAnalyzed() || item->IsNullable())
+            {
+                TreeBuilder<Iterator, Core> builder({aBegin, begin});
+                std::vector<MatchContext<Core>> contexts;
+                MemoCounters memo;
+
+                if (!Run(aRoot, begin, end, builder, aOptions.myMaxDepth, aOptions.myMaxSteps, contexts, memo))
+                    return {};
+
+                return builder.Result();
+            }
+
+            counters.myChunks = chunks;
+
+            RepeatCount count = aRoot->GetCount();
+            Core last         = begin + size;
+
+            BatchOptions batch;
+            batch.myThreads = chunks;
+            batch.myChunk   = 1;
+
+            // A chunk whose cut has no sync point after it is empty
+            std::vector<Core> starts(chunks + 1, last);
+            starts[0] = begin;
+
+            ForEachParallel(
+                chunks - 1, batch, []() { return nullptr; },
+                [&](std::nullptr_t, size_t aIndex) {
+                    Core cut = begin + size * (aIndex + 1) / chunks;
+                    if (auto sync = Search(aSync, cut, last, aOptions.myMaxDepth, aOptions.myMaxSteps))
+                        starts[aIndex + 1] = sync->myBegin;
+                });
+
+            struct Worker
+            {
+                std::vector<MatchContext<Core>> myContexts;
+                TreeBuilder<Iterator, Core> myBuilder;
+                MemoCounters myCounters;
+            };
+
+            auto makeWorker = [&]() { return Worker{{}, TreeBuilder<Iterator, Core>({aBegin, begin}), {}}; };
+            auto coreOf     = [&](Iterator aAt) { return begin + (aAt - aBegin); };
+
+            // Adds the steps taken to aSteps whether or not the item matched
+            auto matchItem = [&](Worker& aWorker, Core aAt, size_t& aSteps) -> std::optional<Success<Iterator>> {
+                aWorker.myBuilder.Reset({aBegin, begin});
+
+                StepCounter steps;
+                bool matched = Run(item, aAt, end, aWorker.myBuilder, aOptions.myMaxDepth, aOptions.myMaxSteps,
+                                   aWorker.myContexts, aWorker.myCounters, steps);
+                aSteps += steps.mySteps;
+
+                if (!matched)
+                    return {};
+
+                return aWorker.myBuilder.Result();
+            };
+
+            struct Chunk
+            {
+                std::vector<Success<Iterator>> myItems;
+                std::vector<size_t> mySteps;
+                Core myEnd;
+
+                // An item failed before the next chunk, if this chunk is used the repeat ends at myEnd after
+                // myStoppedSteps more steps
+                bool myStopped        = false;
+                size_t myStoppedSteps = 0;
+            };
+
+            std::vector<Chunk> results(chunks);
+
+            ForEachParallel(chunks, batch, makeWorker, [&](Worker& aWorker, size_t aIndex) {
+                Chunk& chunk = results[aIndex];
+                Core at      = starts[aIndex];
+
+                while (at < starts[aIndex + 1])
+                {
+                    size_t steps                          = 0;
+                    std::optional<Success<Iterator>> next = matchItem(aWorker, at, steps);
+                    if (!next)
+                    {
+                        chunk.myStopped      = true;
+                        chunk.myStoppedSteps = steps;
+                        break;
+                    }
+
+                    at = coreOf(next->myEnd);
+                    chunk.myItems.push_back(std::move(*next));
+                    chunk.mySteps.push_back(steps);
+                }
+
+                chunk.myEnd = at;
+            });
+
+            Worker worker = makeWorker();
+            std::vector<Success<Iterator>> children;
+            size_t items = 0;
+            size_t steps = 0;
+            size_t next  = 0;
+            Core at      = begin;
+
+            auto take = [&](Success<Iterator>&& aItem) {
+                at = coreOf(aItem.myEnd);
+                items++;
+
+                if (item->IsCaptured())
+                    children.push_back(std::move(aItem));
+                else
+                    for (Success<Iterator>& child : aItem.mySubMatches) children.push_back(std::move(child));
+            };
+
+            while (items < count.myMax)
+            {
+                while (next < chunks && starts[next] < at)
+                {
+                    next++;
+                    counters.myRejected++;
+                }
+
+                if (next < chunks && starts[next] == at)
+                {
+                    Chunk& chunk = results[next++];
+                    counters.myAccepted++;
+
+                    for (size_t i = 0; i < chunk.myItems.size() && items < count.myMax; i++)
+                    {
+                        steps += chunk.mySteps[i];
+                        take(std::move(chunk.myItems[i]));
+                    }
+
+                    if (chunk.myStopped)
+                    {
+                        if (items < count.myMax)
+                            steps += chunk.myStoppedSteps;
+                        break;
+                    }
+
+                    continue;
+                }
+
+                std::optional<Success<Iterator>> single = matchItem(worker, at, steps);
+                if (!single)
+                    break;
+
+                counters.myFallbackItems++;
+                take(std::move(*single));
+            }
+
+            counters.myRejected += chunks - next;
+
+            // Each item also takes a step of the repeat
+            if (items < count.myMin || steps + items >= aOptions.myMaxSteps)
+                return {};
+
+            return Success<Iterator>{aRoot, aBegin, aBegin + (at - begin), std::move(children)};
+        }
+
+        // Matches as Match does while telling aProfiler about every fragment entered, such as a MatchProfile or a
+        // MatchTrace, see ProfileReport and CollapsedStacks
+        template<std::ranges::range Range, ProfilingPolicy Profiler>
+        std::optional<Success<std::ranges::iterator_t<Range>>> Match(Key aRoot, Range& aRange, Profiler& aProfiler,
+                                                                     size_t aMaxDepth = 2'048,
+                                                                     size_t aMaxSteps = 4'294'967'296)
+        {
+            using Iterator = std::ranges::iterator_t<Range>;
+
+            auto [begin, end] = Lower(std::ranges::begin(aRange), std::ranges::end(aRange));
+            TreeBuilder<Iterator, decltype(begin)> builder({std::ranges::begin(aRange), begin});
+            std::vector<MatchContext<decltype(begin)>> contexts;
+
+            if (!Run(this->operator[](aRoot), begin, end, builder, aMaxDepth, aMaxSteps, contexts, myLastMemoCounters,
+                     aProfiler))
+                return {};
+
+            return builder.Result();
+        }
+
+        template<std::ranges::range Range, ProfilingPolicy Profiler>
+        std::optional<std::ranges::iterator_t<Range>> Recognize(Key aRoot, Range& aRange, Profiler& aProfiler,
+                                                                size_t aMaxDepth = 2'048,
+                                                                size_t aMaxSteps = 4'294'967'296)
+        {
+            using Iterator = std::ranges::iterator_t<Range>;
+
+            auto [begin, end] = Lower(std::ranges::begin(aRange), std::ranges::end(aRange));
+            RecognizeBuilder<Iterator, decltype(begin)> builder({std::ranges::begin(aRange), begin});
+            std::vector<MatchContext<decltype(begin)>> contexts;
+
+            if (!Run(this->operator[](aRoot), begin, end, builder, aMaxDepth, aMaxSteps, contexts, myLastMemoCounters,
+                     aProfiler))
+                return {};
+
+            return builder.Result();
+        }
+
+        // The key of aFragment, or of the fragment it was packed from. Literals are named by their value.
+        std::string NameOf(const Fragment* aFragment) const
+        {
+            if (aFragment->GetType() == Fragment::Type::Literal)
+                return "Literal " + std::to_string(aFragment->GetLiteral());
+
+            for (auto& [key, fragment] : myFragments)
+                if (&fragment == aFragment || myPool.Find(&fragment) == aFragment)
+                    return key;
+
+            return "<external>";
+        }
+
+        // A table of the counters in aProfile, costliest fragments first, at most aRows of them
+        std::string ProfileReport(const MatchProfile& aProfile, size_t aRows = 32) const
+        {
+            std::unordered_map<const Fragment*, std::string> names;
+            for (auto& [key, fragment] : myFragments)
+            {
+                names.emplace(&fragment, key);
+                if (const Fragment* packed = myPool.Find(&fragment))
+                    names.emplace(packed, key);
+            }
+
+            std::string out;
+            char line[256];
+
+            snprintf(line, sizeof(line), "%-32s %10s %10s %10s %12s %12s %12s %12s\n", "fragment", "entries",
+                     "successes", "failures", "consumed", "discarded", "inclusive", "exclusive");
+            out += line;
+
+            size_t rows = 0;
+            for (auto& [fragment, counters] : aProfile.SortedByCost())
+            {
+                if (rows++ == aRows)
+                    break;
+
+                auto it          = names.find(fragment);
+                std::string name = it != names.end() ? it->second : NameOf(fragment);
+
+                snprintf(line, sizeof(line), "%-32.32s %10zu %10zu %10zu %12zu %12zu %12zu %12zu\n", name.c_str(),
+                         counters.myEntries, counters.mySuccesses, counters.myFailures, counters.myBytesConsumed,
+                         counters.myBytesDiscarded, counters.myInclusiveSteps, counters.myExclusiveSteps);
+                out += line;
+            }
+
+            return out;
+        }
+
+        void DumpProfile(const MatchProfile& aProfile, size_t aRows = 32) const
+        {
+            fputs(ProfileReport(aProfile, aRows).c_str(), stderr);
+        }
+
+        // The samples of aTrace as collapsed stacks, one "root;child;grandchild steps" line per stack, as read by
+        // flamegraph.pl and most other flamegraph tools
+        std::string CollapsedStacks(const MatchTrace& aTrace) const
+        {
+            std::unordered_map<const Fragment*, std::string> names;
+
+            std::string out;
+            for (auto& [stack, steps] : aTrace.Samples())
+            {
+                for (size_t i = 0; i < stack.size(); i++)
+                {
+                    auto it = names.find(stack[i]);
+                    if (it == names.end())
+                    {
+                        // Frames are split on ';', the count is split off at the last space so names may have spaces
+                        std::string name = NameOf(stack[i]);
+                        std::ranges::replace(name, ';', ':');
+
+                        it = names.emplace(stack[i], std::move(name)).first;
+                    }
+
+                    if (i != 0)
+                        out += ';';
+                    out += it->second;
+                }
+
+                out += ' ';
+                out += std::to_string(steps);
+                out += '\n';
+            }
+
+            return out;
+        }
+
+        // Writes CollapsedStacks to aPath, false if it could not be written
+        bool WriteCollapsedStacks(const MatchTrace& aTrace, const std::filesystem::path& aPath) const
+        {
+            std::ofstream out(aPath, std::ios::binary);
+            out << CollapsedStacks(aTrace);
+
+            return static_cast<bool>(out);
+        }
+
+        // Lets alternatives skip branches that cannot start with the next byte, see pattern_matcher::Analyze. Has to
+        // be redone after fragments are changed.
+        void Analyze()
+        {
+            if (IsPacked())
+            {
+                pattern_matcher::Analyze(myPool.Fragments());
+                return;
+            }
+
+            std::vector<Fragment*> fragments;
+            fragments.reserve(myFragments.size());
+
+            for (auto& [key, fragment] : myFragments) fragments.push_back(&fragment);
+
+            pattern_matcher::Analyze(fragments);
+        }
+
+        // Starts recognizing aRoot over input fed in chunks, see MatchSession
+        MatchSession Stream(Key aRoot, size_t aMaxDepth = 2'048)
+        {
+            return MatchSession(this->operator[](aRoot), aMaxDepth);
+        }
+
+        // Lowers the fragment graph reachable from aRoot into bytecode, see Program
+        Program Compile(Key aRoot) { return Compile(this->operator[](aRoot)); }
+        Program Compile(const Fragment* aRoot) const { return Program::Compile(aRoot); }
+
+        // Generates native code recognizing aRoot, see JitProgram
+        std::optional<JitProgram> Jit(Key aRoot) { return Jit(this->operator[](aRoot)); }
+        std::optional<JitProgram> Jit(const Fragment* aRoot) const { return JitProgram::Compile(aRoot); }
+
+        const std::unordered_map<Key, Fragment>& Fragments() 
+        {
+            return myFragments;
+        }
+
+        // Applies to every following call to Match, see MemoPolicy
+        void SetMemoPolicy(MemoPolicy aPolicy) { myMemoPolicy = aPolicy; }
+        MemoPolicy GetMemoPolicy() const { return myMemoPolicy; }
+
+        // Hits and misses of the memo table during the latest call to Match
+        const MemoCounters& LastMemoCounters() const { return myLastMemoCounters; }
+
+    private:
+        template<class>
+        friend class CompiledGrammar;
+
+        // Most grammars nest shallower than this, so the context stack rarely grows during a match
+        static constexpr size_t InitialContextCapacity = 64;
+
+        template<class Iterator, class Sentinel, class Builder>
+        bool Run(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd, Builder& aBuilder, size_t aMaxDepth,
+                 size_t aMaxSteps)
+        {
+            std::vector<MatchContext<Iterator>> contexts;
+            return Run(aRoot, aBegin, aEnd, aBuilder, aMaxDepth, aMaxSteps, contexts, myLastMemoCounters);
+        }
+
+        template<template<class, class> class Builder, std::ranges::random_access_range Inputs, class Product>
+        void RunMany(const Fragment* aRoot, Inputs& aInputs, const BatchOptions& aOptions,
+                     std::vector<std::optional<Product>>& aOut) const
+        {
+            using Iterator = BatchIterator<Inputs>;
+            using Sentinel = std::ranges::sentinel_t<std::remove_reference_t<std::ranges::range_reference_t<Inputs>>>;
+            using Core     = decltype(Lower(std::declval<Iterator>(), std::declval<Sentinel>()).first);
+
+            struct Worker
+            {
+                std::vector<MatchContext<Core>> myContexts;
+                std::optional<Builder<Iterator, Core>> myBuilder;
+                MemoCounters myCounters;
+            };
+
+            aOut.resize(static_cast<size_t>(std::ranges::distance(aInputs)));
+
+            ForEachParallel(
+                aOut.size(), aOptions, []() { return Worker{}; },
+                [&](Worker& aWorker, size_t aIndex) {
+                    auto&& input     = std::ranges::begin(aInputs)[aIndex];
+                    Iterator begin   = std::ranges::begin(input);
+                    auto [core, end] = Lower(begin, std::ranges::end(input));
+                    Rebase<Iterator, Core> rebase(begin, core);
+
+                    if (aWorker.myBuilder)
+                        aWorker.myBuilder->Reset(rebase);
+                    else
+                        aWorker.myBuilder.emplace(rebase);
+
+                    if (Run(aRoot, core, end, *aWorker.myBuilder, aOptions.myMaxDepth, aOptions.myMaxSteps,
+                            aWorker.myContexts, aWorker.myCounters))
+                        aOut[aIndex] = aWorker.myBuilder->Result();
+                });
+        }
+
+        // Only reads the matcher, the context stack is the caller's to reuse between runs so several runs may go on at
+        // once on different threads. aProfiler is told about every fragment entered and left, see Profile.h.
+        template<class Iterator, class Sentinel, class Builder, class Profiler = NoProfile>
+        bool Run(const Fragment* aRoot, Iterator aBegin, Sentinel aEnd, Builder& aBuilder, size_t aMaxDepth,
+                 size_t aMaxSteps, std::vector<MatchContext<Iterator>>& aContexts, MemoCounters& aCounters,
+                 Profiler&& aProfiler = {}) const
+        {
+            // A memoized failure has no product
+            struct MemoEntry
+            {
+                Iterator myEnd;
+                size_t myHeight;
+                std::optional<typename Builder::Product> myProduct;
+            };
+
+            // Whether no match of a fragment fits in what remains from aAt, and whether every match does so its leaves
+            // may skip their end of input checks. Only known when the remaining length is cheap to compute.
+            auto tooShort = [aEnd](const Fragment* aFragment, Iterator aAt) -> bool {
+                if constexpr (std::sized_sentinel_for<Sentinel, Iterator>)
+                    return static_cast<size_t>(aEnd - aAt) < aFragment->MinLength();
+                else
+                    return false;
+            };
+            auto fits = [aEnd](const Fragment* aFragment, Iterator aAt) -> bool {
+                if constexpr (std::sized_sentinel_for<Sentinel, Iterator>)
+                    return static_cast<size_t>(aEnd - aAt) >= aFragment->MaxLength();
+                else
+                    return false;
+            };
+            auto distance = [](Iterator aFrom, Iterator aTo) -> size_t {
+                if constexpr (std::sized_sentinel_for<Iterator, Iterator>)
+                    return static_cast<size_t>(aTo - aFrom);
+                else
+                    return 0;
+            };
+
+            if (tooShort(aRoot, aBegin))
+            {
+                aCounters = {};
+                return false;
+            }
+
             size_t steps = 0;
-            std::stack<MatchContext<Iterator>> contexts;
+            aContexts.clear();
+            aContexts.reserve(std::min<size_t>(aMaxDepth, InitialContextCapacity));
+
+            // Memo entries are keyed on offsets, which is only cheap to compute for random access iterators
+            MemoTable<MemoEntry> memo(std::random_access_iterator<Iterator> ? myMemoPolicy : MemoPolicy::None);
+            auto offsetOf = [aBegin](Iterator aAt) -> size_t {
+                if constexpr (std::random_access_iterator<Iterator>)
+                    return static_cast<size_t>(aAt - aBegin);
+                else
+                    return 0;
+            };
+
+            aContexts.push_back(aRoot->BeginMatch(aBegin));
+            aContexts.back().myUnchecked = fits(aRoot, aBegin);
+            aBuilder.Enter(aContexts.back());
 
-            contexts.push(aRoot->BeginMatch(aBegin));
+            aProfiler.Start();
+            aProfiler.Enter(aRoot, steps);
 
             Result<Iterator> lastResult;
 
             constexpr bool debugDump = false;
 
-            while (!contexts.empty())
+            while (!aContexts.empty())
             {
-                MatchContext<Iterator>& ctx = contexts.top();
+                MatchContext<Iterator>& ctx = aContexts.back();
 
                 const Fragment* fragment = ctx.myFragment;
 
                 if (debugDump)
-                    DebugDump(contexts, aEnd);
+                    DebugDump(aContexts, aEnd);
+
+                aProfiler.Step();
 
                 lastResult = ctx.myFragment->ResumeMatch(ctx, lastResult, aEnd);
 
@@ -282,18 +1114,99 @@ namespace pattern_matcher
 
                 switch (lastResult.GetType())
                 {
-                    case MatchResultType::Success:
+                    case MatchResultType::Success: {
+                        const Success<Iterator>& success = lastResult.Success();
+                        MatchContext<Iterator>* parent   = aContexts.size() > 1 ? &aContexts[aContexts.size() - 2] : nullptr;
+
+                        if (fragment->IsSpan())
+                            aBuilder.Span(ctx, success);
+
+                        if (memo.Enabled() && memo.ShouldMemoize(fragment) && !ctx.myTruncated)
+                            memo.Store(fragment, offsetOf(ctx.myBegin),
+                                       MemoEntry{success.myEnd, ctx.myHeight, aBuilder.Snapshot(ctx, success)});
+
+                        if (parent)
+                        {
+                            parent->myTruncated = parent->myTruncated || ctx.myTruncated;
+                            parent->myHeight    = std::max(parent->myHeight, ctx.myHeight + 1);
+                        }
+
+                        aProfiler.Leave(steps, true, distance(success.myBegin, success.myEnd));
+
+                        aBuilder.Leave(ctx, success, parent);
+                        aContexts.pop_back();
+                    }
+                    break;
+
                     case MatchResultType::Failure:
-                        contexts.pop();
+                        if (memo.Enabled() && memo.ShouldMemoize(fragment) && !ctx.myTruncated)
+                            memo.Store(fragment, offsetOf(ctx.myBegin),
+                                       MemoEntry{ctx.myBegin, ctx.myHeight, std::nullopt});
+
+                        if (aContexts.size() > 1)
+                        {
+                            MatchContext<Iterator>& parent = aContexts[aContexts.size() - 2];
+                            parent.myTruncated             = parent.myTruncated || ctx.myTruncated;
+                            parent.myHeight                = std::max(parent.myHeight, ctx.myHeight + 1);
+                        }
+
+                        aProfiler.Leave(steps, false, distance(ctx.myBegin, ctx.myAt));
+
+                        aBuilder.Abandon(ctx);
+                        aContexts.pop_back();
                         break;
 
                     case MatchResultType::InProgress:
-                        if (contexts.size() >= aMaxDepth)
+                        if (aContexts.size() >= aMaxDepth)
+                        {
+                            ctx.myTruncated = true;
+                            lastResult      = MatchFailure{};
+                            break;
+                        }
+
+                        if (tooShort(lastResult.Context().myFragment, lastResult.Context().myBegin))
                         {
                             lastResult = MatchFailure{};
                             break;
                         }
-                        contexts.push(lastResult.Context());
+
+                        if (memo.Enabled())
+                        {
+                            const MatchContext<Iterator>& next = lastResult.Context();
+
+                            // An entry is only replayed where running the fragment again would not reach the depth
+                            // limit either, both its successes and failures can change once it does
+                            auto usable = [&](const MemoEntry& aEntry) {
+                                return aContexts.size() + aEntry.myHeight <= aMaxDepth;
+                            };
+
+                            if (const MemoEntry* cached = memo.Lookup(next.myFragment, offsetOf(next.myBegin), usable))
+                            {
+                                ctx.myHeight = std::max(ctx.myHeight, cached->myHeight + 1);
+
+                                if (cached->myProduct)
+                                {
+                                    aBuilder.Replay(*cached->myProduct, ctx);
+                                    lastResult = Success<Iterator>{next.myFragment, next.myBegin, cached->myEnd};
+                                }
+                                else
+                                {
+                                    lastResult = MatchFailure{};
+                                }
+                                break;
+                            }
+                        }
+
+                        {
+                            bool unchecked = ctx.myUnchecked;
+
+                            aContexts.push_back(lastResult.TakeContext());
+
+                            MatchContext<Iterator>& next = aContexts.back();
+                            next.myUnchecked = unchecked || fits(next.myFragment, next.myBegin);
+                        }
+                        aBuilder.Enter(aContexts.back());
+                        aProfiler.Enter(aContexts.back().myFragment, steps);
                         lastResult = {};
                         break;
                     case MatchResultType::None:
@@ -302,16 +1215,21 @@ namespace pattern_matcher
                 }
 
                 if (steps++ >= aMaxSteps)
-                    return {};
+                {
+                    aCounters = memo.Counters();
+                    return false;
+                }
             }
 
+            aCounters = memo.Counters();
+
             switch (lastResult.GetType())
             {
                 case MatchResultType::Success:
-                    return lastResult.Success();
+                    return true;
 
                 case MatchResultType::Failure:
-                    return {};
+                    return false;
 
                 case MatchResultType::InProgress:
                 case MatchResultType::None:
@@ -322,19 +1240,11 @@ namespace pattern_matcher
             std::unreachable();
         }
 
-        std::optional<Success<const char*>> Match(Key aRoot, const char* aRange, size_t aMaxDepth = 2'048,
-                                                  size_t aMaxSteps = 4'294'967'296)
-        {
-            return Match(this->operator[](aRoot), aRange, aRange + ::strlen(aRange), aMaxDepth, aMaxSteps);
-        }
-
-        const std::unordered_map<Key, Fragment>& Fragments() 
-        {
-            return myFragments;
-        }
-
-    private:
         std::unordered_map<Key, Fragment> myFragments;
+        FragmentPool myPool;
+
+        MemoPolicy myMemoPolicy = MemoPolicy::None;
+        MemoCounters myLastMemoCounters;
 
         static const PatternMatcherLiterals ourLiterals;
     };
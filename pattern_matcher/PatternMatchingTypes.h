@@ -153,7 +153,16 @@ namespace pattern_matcher
         Iterator myAt;
         int myIndex;
 
-        std::vector<Success<Iterator>> mySubMatches;
+        // Set when at least the fragment's MaxLength remains of the input, leaves then skip their end of input checks
+        bool myUnchecked;
+
+        // Set when a child, or one of its children, was failed for reaching the depth limit. The result then depends
+        // on how deep the fragment was entered and must not be memoized.
+        bool myTruncated;
+
+        // Most contexts open at once from this one down, itself included. A memoized result of the fragment holds
+        // wherever that many more still fit under the depth limit.
+        size_t myHeight;
     };
 
     template<class Iterator>
@@ -162,11 +171,18 @@ namespace pattern_matcher
         using SuccessType = Success<Iterator>;
         using ContextType = MatchContext<Iterator>;
 
-        Result(SuccessType aResult) : myResult(aResult) {}
+        Result(SuccessType&& aResult) : myResult(std::move(aResult)) {}
         Result(MatchFailure aResult) : myResult(aResult) {}
-        Result(ContextType aResult) : myResult(aResult) {}
+        Result(ContextType&& aResult) : myResult(std::move(aResult)) {}
         Result() : myResult(MatchNone{}) {}
 
+        // Results are handed from a fragment to the matcher once, copying them would copy the sub matches as well
+        Result(const Result&)            = delete;
+        Result& operator=(const Result&) = delete;
+
+        Result(Result&&)            = default;
+        Result& operator=(Result&&) = default;
+
         MatchResultType GetType() const
         {
             switch (myResult.index())
@@ -188,6 +204,9 @@ namespace pattern_matcher
 
         const ContextType& Context() const { return std::get<ContextType>(myResult); }
 
+        SuccessType&& TakeSuccess() { return std::get<SuccessType>(std::move(myResult)); }
+        ContextType&& TakeContext() { return std::get<ContextType>(std::move(myResult)); }
+
     private:
         std::variant<SuccessType, MatchFailure, ContextType, MatchNone> myResult;
     };
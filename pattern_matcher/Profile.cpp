@@ -0,0 +1,20 @@
+#include "pattern_matcher/Profile.h"
+
+#include <algorithm>
+
+namespace pattern_matcher
+{
+    std::vector<std::pair<const Fragment*, FragmentCounters>> MatchProfile::SortedByCost() const
+    {
+        std::vector<std::pair<const Fragment*, FragmentCounters>> out(std::begin(myCounters), std::end(myCounters));
+
+        std::sort(std::begin(out), std::end(out), [](const auto& aLeft, const auto& aRight) {
+            if (aLeft.second.myExclusiveSteps != aRight.second.myExclusiveSteps)
+                return aLeft.second.myExclusiveSteps > aRight.second.myExclusiveSteps;
+
+            return aLeft.second.myInclusiveSteps > aRight.second.myInclusiveSteps;
+        });
+
+        return out;
+    }
+}  // namespace pattern_matcher
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "pattern_matcher/Fragment.h"
+
+namespace pattern_matcher
+{
+    struct FragmentCounters
+    {
+        size_t myEntries   = 0;
+        size_t mySuccesses = 0;
+        size_t myFailures  = 0;
+
+        // Input taken by successful matches
+        size_t myBytesConsumed = 0;
+        // Input a failed match had got through before giving up, thrown away when its parent backtracked
+        size_t myBytesDiscarded = 0;
+
+        // Steps taken while the fragment was open, counting those of its children, and steps taken on it alone. A
+        // recursive fragment counts the steps of its nested entries again in its inclusive steps.
+        size_t myInclusiveSteps = 0;
+        size_t myExclusiveSteps = 0;
+    };
+
+    // Profiling policy of the matching loop that records nothing. Every hook is empty and inlined away, so matching
+    // without a profile costs the same as before profiling existed.
+    struct NoProfile
+    {
+        static constexpr bool Enabled = false;
+
+        void Start() {}
+        void Enter(const Fragment* aFragment, size_t aStep) {}
+        void Step() {}
+        void Leave(size_t aStep, bool aSuccess, size_t aBytes) {}
+    };
+
+    // Policies that record something, anything else passed where a policy could go is a plain argument
+    template<class T>
+    concept ProfilingPolicy = T::Enabled;
+
+    // Profiling policy that only counts the steps taken, over every match it is passed to
+    struct StepCounter
+    {
+        static constexpr bool Enabled = true;
+
+        void Start() {}
+        void Enter(const Fragment* aFragment, size_t aStep) {}
+        void Step() { mySteps++; }
+        void Leave(size_t aStep, bool aSuccess, size_t aBytes) {}
+
+        size_t mySteps = 0;
+    };
+
+    // Profiling policy that adds up FragmentCounters for every fragment entered, over every match it is passed to
+    class MatchProfile
+    {
+    public:
+        static constexpr bool Enabled = true;
+
+        void Start() { myOpen.clear(); }
+
+        void Enter(const Fragment* aFragment, size_t aStep)
+        {
+            FragmentCounters& counters = myCounters[aFragment];
+            counters.myEntries++;
+            myOpen.push_back({&counters, aStep});
+        }
+
+        void Step() { myOpen.back().first->myExclusiveSteps++; }
+
+        // aBytes is what a success consumed or what a failure discarded
+        void Leave(size_t aStep, bool aSuccess, size_t aBytes)
+        {
+            auto [counters, entered] = myOpen.back();
+            myOpen.pop_back();
+
+            counters->myInclusiveSteps += aStep - entered;
+
+            if (aSuccess)
+            {
+                counters->mySuccesses++;
+                counters->myBytesConsumed += aBytes;
+            }
+            else
+            {
+                counters->myFailures++;
+                counters->myBytesDiscarded += aBytes;
+            }
+        }
+
+        const std::unordered_map<const Fragment*, FragmentCounters>& Counters() const { return myCounters; }
+
+        // Most exclusive steps first, ties broken by inclusive steps
+        std::vector<std::pair<const Fragment*, FragmentCounters>> SortedByCost() const;
+
+        void Clear()
+        {
+            myCounters.clear();
+            myOpen.clear();
+        }
+
+    private:
+        std::unordered_map<const Fragment*, FragmentCounters> myCounters;
+
+        // Counters of the open fragments and the step each was entered at, nodes of myCounters stay where they are
+        std::vector<std::pair<FragmentCounters*, size_t>> myOpen;
+    };
+
+    // Profiling policy that samples the stack of open fragments every aInterval steps, for flamegraphs of which rule
+    // chains the steps go to. See PatternMatcher::CollapsedStacks.
+    class MatchTrace
+    {
+    public:
+        static constexpr bool Enabled = true;
+
+        explicit MatchTrace(size_t aInterval = 1) : myInterval(aInterval ? aInterval : 1) {}
+
+        void Start()
+        {
+            myStack.clear();
+            myUntilSample = myInterval;
+        }
+
+        void Enter(const Fragment* aFragment, size_t aStep) { myStack.push_back(aFragment); }
+
+        void Step()
+        {
+            if (--myUntilSample != 0)
+                return;
+
+            myUntilSample = myInterval;
+
+            auto it = mySamples.find(myStack);
+            if (it == mySamples.end())
+                it = mySamples.emplace(myStack, 0).first;
+
+            it->second += myInterval;
+        }
+
+        void Leave(size_t aStep, bool aSuccess, size_t aBytes) { myStack.pop_back(); }
+
+        // Stacks from the root outwards, each with the steps it was sampled for
+        const std::map<std::vector<const Fragment*>, size_t>& Samples() const { return mySamples; }
+
+        size_t Interval() const { return myInterval; }
+
+        void Clear()
+        {
+            mySamples.clear();
+            myStack.clear();
+            myUntilSample = myInterval;
+        }
+
+    private:
+        size_t myInterval;
+        size_t myUntilSample = myInterval;
+
+        std::vector<const Fragment*> myStack;
+        std::map<std::vector<const Fragment*>, size_t> mySamples;
+    };
+}  // namespace pattern_matcher
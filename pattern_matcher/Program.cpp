@@ -0,0 +1,256 @@
+#include "pattern_matcher/Program.h"
+
+#include <cassert>
+#include <unordered_map>
+
+namespace pattern_matcher
+{
+    class ProgramCompiler
+    {
+    public:
+        using OpCode = Program::OpCode;
+
+        Program Compile(const Fragment* aRoot)
+        {
+            Emit(OpCode::Call, CallTarget(aRoot));
+            Emit(OpCode::End);
+
+            while (!myPending.empty())
+            {
+                const Fragment* fragment = myPending.back();
+                myPending.pop_back();
+
+                myEntries[fragment] = Here();
+                EmitSubroutine(fragment);
+            }
+
+            for (auto [at, fragment] : myCalls) myProgram.myCode[at].myArgument = myEntries.at(fragment);
+
+            return std::move(myProgram);
+        }
+
+    private:
+        std::uint32_t Here() const { return static_cast<std::uint32_t>(myProgram.myCode.size()); }
+
+        std::uint32_t Emit(OpCode aOp, std::uint32_t aArgument = 0, Fragment::Literal aLiteral = 0)
+        {
+            myProgram.myCode.push_back({aOp, aLiteral, aArgument});
+            return Here() - 1;
+        }
+
+        void Patch(std::uint32_t aAt, std::uint32_t aTarget) { myProgram.myCode[aAt].myArgument = aTarget; }
+
+        std::uint32_t IdOf(const Fragment* aFragment)
+        {
+            auto [it, inserted] = myIds.try_emplace(aFragment, static_cast<std::uint32_t>(myIds.size()));
+
+            if (inserted)
+                myProgram.myFragments.push_back(aFragment);
+
+            return it->second;
+        }
+
+        std::uint32_t CallTarget(const Fragment* aFragment)
+        {
+            if (!myEntries.contains(aFragment))
+            {
+                myEntries[aFragment] = Program::NoFragment;
+                myPending.push_back(aFragment);
+            }
+
+            myCalls.push_back({Here(), aFragment});
+            return 0;
+        }
+
+        bool IsLeaf(const Fragment* aFragment)
+        {
+            switch (aFragment->GetType())
+            {
+                case Fragment::Type::Literal:
+                case Fragment::Type::String:
+                case Fragment::Type::CharClass:
+                    return true;
+                case Fragment::Type::Alternative:
+                    return aFragment->LookupPortion() > 0
+                        && aFragment->LookupPortion() == aFragment->SubFragments().size();
+                default:
+                    return false;
+            }
+        }
+
+        // Matches the literal portion of an alternative without capturing the alternative itself
+        void EmitLookup(const Fragment* aAlternative)
+        {
+            std::uint32_t index = static_cast<std::uint32_t>(myProgram.myClasses.size());
+            auto& fragments     = myProgram.myClasses.emplace_back();
+
+            for (size_t i = 0; i < fragments.size(); i++)
+            {
+                Fragment::SmallIndex sub = aAlternative->LookupIndex(static_cast<Fragment::Literal>(i));
+                fragments[i]             = sub == Fragment::NoIndex ? Program::NoFragment
+                                                                    : IdOf(aAlternative->SubFragments()[sub]);
+            }
+
+            Emit(OpCode::Class, index);
+        }
+
+        void EmitClass(const Fragment* aClass)
+        {
+            std::uint32_t index = static_cast<std::uint32_t>(myProgram.myClasses.size());
+            std::uint32_t id    = IdOf(aClass);
+            auto& fragments     = myProgram.myClasses.emplace_back();
+
+            for (size_t i = 0; i < fragments.size(); i++)
+                fragments[i] = aClass->GetClass().Contains(static_cast<Fragment::Literal>(i)) ? id : Program::NoFragment;
+
+            Emit(OpCode::Class, index);
+        }
+
+        void EmitChild(const Fragment* aFragment)
+        {
+            if (!IsLeaf(aFragment))
+            {
+                Emit(OpCode::Call, CallTarget(aFragment));
+                return;
+            }
+
+            EmitInline(aFragment);
+        }
+
+        void EmitInline(const Fragment* aFragment)
+        {
+            switch (aFragment->GetType())
+            {
+                case Fragment::Type::Literal:
+                    Emit(OpCode::Char, IdOf(aFragment), aFragment->GetLiteral());
+                    break;
+
+                case Fragment::Type::String:
+                    Emit(OpCode::String, IdOf(aFragment));
+                    break;
+
+                case Fragment::Type::CharClass:
+                    EmitClass(aFragment);
+                    break;
+
+                case Fragment::Type::Sequence:
+                    Emit(OpCode::Open, IdOf(aFragment));
+                    for (const Fragment* sub : aFragment->SubFragments()) EmitChild(sub);
+                    Emit(OpCode::Close);
+                    break;
+
+                case Fragment::Type::Alternative:
+                    EmitAlternative(aFragment);
+                    break;
+
+                case Fragment::Type::Repeat:
+                    EmitRepeat(aFragment);
+                    break;
+
+                case Fragment::Type::None:
+                    Emit(OpCode::Fail);
+                    break;
+            }
+        }
+
+        void EmitSubroutine(const Fragment* aFragment)
+        {
+            EmitInline(aFragment);
+            Emit(OpCode::Return);
+        }
+
+        void EmitAlternative(const Fragment* aFragment)
+        {
+            Fragment::Children subFragments = aFragment->SubFragments();
+            size_t portion                  = aFragment->LookupPortion();
+            std::vector<std::uint32_t> toEnd;
+
+            Emit(OpCode::Open, IdOf(aFragment));
+
+            if (subFragments.empty())
+                Emit(OpCode::Fail);
+
+            if (portion > 0)
+            {
+                if (portion == subFragments.size())
+                {
+                    EmitLookup(aFragment);
+                }
+                else
+                {
+                    std::uint32_t choice = Emit(OpCode::Choice);
+                    EmitLookup(aFragment);
+                    toEnd.push_back(Emit(OpCode::Commit));
+                    Patch(choice, Here());
+                }
+            }
+
+            for (size_t i = portion; i < subFragments.size(); i++)
+            {
+                if (i + 1 == subFragments.size())
+                {
+                    EmitChild(subFragments[i]);
+                    break;
+                }
+
+                std::uint32_t choice = Emit(OpCode::Choice);
+                EmitChild(subFragments[i]);
+                toEnd.push_back(Emit(OpCode::Commit));
+                Patch(choice, Here());
+            }
+
+            for (std::uint32_t at : toEnd) Patch(at, Here());
+
+            Emit(OpCode::Close);
+        }
+
+        void EmitRepeat(const Fragment* aFragment)
+        {
+            const Fragment* sub = aFragment->SubFragments()[0];
+            RepeatCount count   = aFragment->GetCount();
+
+            Emit(OpCode::Open, IdOf(aFragment));
+
+            for (size_t i = 0; i < count.myMin && i < count.myMax; i++) EmitChild(sub);
+
+            if (count.myMax == RepeatCount::Unbounded)
+            {
+                std::uint32_t choice = Emit(OpCode::Choice);
+                std::uint32_t loop   = Here();
+                EmitChild(sub);
+                Emit(OpCode::PartialCommit, loop);
+                Patch(choice, Here());
+            }
+            else if (count.myMax > count.myMin)
+            {
+                // Bounded repeats are unrolled, each optional iteration backtracks to the end of the loop
+                std::vector<std::uint32_t> choices;
+                for (size_t i = count.myMin; i < count.myMax; i++)
+                {
+                    choices.push_back(Emit(OpCode::Choice));
+                    EmitChild(sub);
+                    std::uint32_t commit = Emit(OpCode::Commit);
+                    Patch(commit, Here());
+                }
+
+                for (std::uint32_t at : choices) Patch(at, Here());
+            }
+
+            Emit(OpCode::Close);
+        }
+
+        Program myProgram;
+
+        std::unordered_map<const Fragment*, std::uint32_t> myIds;
+        std::unordered_map<const Fragment*, std::uint32_t> myEntries;
+        std::vector<const Fragment*> myPending;
+        std::vector<std::pair<std::uint32_t, const Fragment*>> myCalls;
+    };
+
+    Program Program::Compile(const Fragment* aRoot)
+    {
+        assert(aRoot);
+
+        return ProgramCompiler().Compile(aRoot);
+    }
+}  // namespace pattern_matcher
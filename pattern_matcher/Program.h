@@ -0,0 +1,264 @@
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <vector>
+
+#include "pattern_matcher/Fragment.h"
+#include "pattern_matcher/PatternMatchingTypes.h"
+
+namespace pattern_matcher
+{
+    // A fragment graph lowered into a flat instruction array, run by a backtracking interpreter instead of walking
+    // the fragments. Produces the same results as PatternMatcher::Match, with the exception that the depth limit only
+    // counts fragments that are not leaves.
+    class Program
+    {
+    public:
+        enum class OpCode : std::uint8_t
+        {
+            // Match myLiteral and capture fragment myArgument as a leaf
+            Char,
+            // Match any byte in class myArgument and capture the fragment it maps to as a leaf
+            Class,
+            // Match the string of fragment myArgument and capture it as a leaf
+            String,
+            // Push a backtrack entry resuming at myArgument
+            Choice,
+            // Pop the top backtrack entry and jump to myArgument
+            Commit,
+            // Move the top backtrack entry to the current position and jump to myArgument
+            PartialCommit,
+            // Push a return address and jump to myArgument
+            Call,
+            Return,
+            // Begin capturing fragment myArgument
+            Open,
+            // End the innermost capture
+            Close,
+            Fail,
+            End
+        };
+
+        struct Instruction
+        {
+            OpCode myOp;
+            Fragment::Literal myLiteral;
+            std::uint32_t myArgument;
+        };
+
+        static constexpr std::uint32_t NoFragment = std::numeric_limits<std::uint32_t>::max();
+
+        static Program Compile(const Fragment* aRoot);
+
+        const std::vector<Instruction>& Code() const { return myCode; }
+        const std::vector<const Fragment*>& Fragments() const { return myFragments; }
+
+        template<class Iterator, class Sentinel>
+            requires std::equality_comparable_with<std::iter_value_t<Iterator>, Fragment::Literal>
+                  && std::equality_comparable_with<Iterator, Sentinel>
+        std::optional<Success<Iterator>> Match(Iterator aBegin, Sentinel aEnd, size_t aMaxDepth = 2'048,
+                                               size_t aMaxSteps = 4'294'967'296) const
+        {
+            struct Capture
+            {
+                std::uint32_t myFragment;
+                std::uint32_t mySize;
+                Iterator myBegin;
+                Iterator myEnd;
+            };
+
+            struct Frame
+            {
+                std::uint32_t myTarget;
+                std::uint32_t myCaptures;  // NoFragment for return addresses
+                std::uint32_t myDepth;
+                Iterator myAt;
+            };
+
+            std::vector<Capture> captures;
+            std::vector<std::uint32_t> open;
+            std::vector<Frame> frames;
+
+            Iterator at     = aBegin;
+            std::uint32_t pc = 0;
+            size_t steps    = 0;
+
+            while (true)
+            {
+                if (steps++ >= aMaxSteps)
+                    return {};
+
+                const Instruction& instruction = myCode[pc];
+                bool failed                    = false;
+
+                switch (instruction.myOp)
+                {
+                    case OpCode::Char:
+                        if (at == aEnd || instruction.myLiteral != static_cast<Fragment::Literal>(*at))
+                        {
+                            failed = true;
+                            break;
+                        }
+                        captures.push_back({instruction.myArgument, 1, at, std::next(at)});
+                        ++at;
+                        pc++;
+                        break;
+
+                    case OpCode::Class: {
+                        if (at == aEnd)
+                        {
+                            failed = true;
+                            break;
+                        }
+
+                        std::uint32_t fragment = myClasses[instruction.myArgument][(Fragment::Literal)*at];
+                        if (fragment == NoFragment)
+                        {
+                            failed = true;
+                            break;
+                        }
+                        captures.push_back({fragment, 1, at, std::next(at)});
+                        ++at;
+                        pc++;
+                    }
+                    break;
+
+                    case OpCode::String: {
+                        Iterator begin = at;
+
+                        for (char c : myFragments[instruction.myArgument]->GetString())
+                        {
+                            if (at == aEnd || static_cast<Fragment::Literal>(c) != static_cast<Fragment::Literal>(*at))
+                            {
+                                failed = true;
+                                break;
+                            }
+                            ++at;
+                        }
+
+                        if (failed)
+                            break;
+
+                        captures.push_back({instruction.myArgument, 1, begin, at});
+                        pc++;
+                    }
+                    break;
+
+                    case OpCode::Choice:
+                        frames.push_back({instruction.myArgument, static_cast<std::uint32_t>(captures.size()),
+                                          static_cast<std::uint32_t>(open.size()), at});
+                        pc++;
+                        break;
+
+                    case OpCode::Commit:
+                        frames.pop_back();
+                        pc = instruction.myArgument;
+                        break;
+
+                    case OpCode::PartialCommit:
+                        frames.back().myAt       = at;
+                        frames.back().myCaptures = static_cast<std::uint32_t>(captures.size());
+                        pc                       = instruction.myArgument;
+                        break;
+
+                    case OpCode::Call:
+                        frames.push_back({pc + 1, NoFragment, 0, at});
+                        pc = instruction.myArgument;
+                        break;
+
+                    case OpCode::Return:
+                        pc = frames.back().myTarget;
+                        frames.pop_back();
+                        break;
+
+                    case OpCode::Open:
+                        if (!open.empty() && open.size() >= aMaxDepth)
+                        {
+                            failed = true;
+                            break;
+                        }
+                        open.push_back(static_cast<std::uint32_t>(captures.size()));
+                        captures.push_back({instruction.myArgument, 0, at, at});
+                        pc++;
+                        break;
+
+                    case OpCode::Close: {
+                        Capture& capture = captures[open.back()];
+                        capture.myEnd    = at;
+                        capture.mySize   = static_cast<std::uint32_t>(captures.size() - open.back());
+                        open.pop_back();
+                        pc++;
+                    }
+                    break;
+
+                    case OpCode::Fail:
+                        failed = true;
+                        break;
+
+                    case OpCode::End: {
+                        size_t index = 0;
+                        return Build(captures, index);
+                    }
+                }
+
+                if (!failed)
+                    continue;
+
+                while (!frames.empty() && frames.back().myCaptures == NoFragment) frames.pop_back();
+
+                if (frames.empty())
+                    return {};
+
+                Frame& frame = frames.back();
+
+                at = frame.myAt;
+                pc = frame.myTarget;
+                captures.resize(frame.myCaptures);
+                open.resize(frame.myDepth);
+                frames.pop_back();
+            }
+        }
+
+    private:
+        template<class Capture, class Iterator = decltype(Capture::myBegin)>
+        Success<Iterator> Build(const std::vector<Capture>& aCaptures, size_t& aIndex) const
+        {
+            const Capture& capture = aCaptures[aIndex++];
+            size_t end             = aIndex - 1 + capture.mySize;
+
+            Success<Iterator> out{myFragments[capture.myFragment], capture.myBegin, capture.myEnd, {}};
+
+            while (aIndex < end) BuildInto(aCaptures, aIndex, out);
+
+            return out;
+        }
+
+        // Fragments that are not captured give their children to aParent
+        template<class Capture, class Iterator = decltype(Capture::myBegin)>
+        void BuildInto(const std::vector<Capture>& aCaptures, size_t& aIndex, Success<Iterator>& aParent) const
+        {
+            const Capture& capture = aCaptures[aIndex];
+
+            if (myFragments[capture.myFragment]->IsCaptured())
+            {
+                aParent.mySubMatches.push_back(Build(aCaptures, aIndex));
+                return;
+            }
+
+            size_t end = aIndex + capture.mySize;
+            aIndex++;
+
+            while (aIndex < end) BuildInto(aCaptures, aIndex, aParent);
+        }
+
+        std::vector<Instruction> myCode;
+        std::vector<const Fragment*> myFragments;
+        std::vector<std::array<std::uint32_t, 1 << (sizeof(Fragment::Literal) * CHAR_BIT)>> myClasses;
+
+        friend class ProgramCompiler;
+    };
+}  // namespace pattern_matcher
@@ -0,0 +1,349 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "pattern_matcher/CompiledGrammar.h"
+#include "pattern_matcher/MappedFile.h"
+#include "pattern_matcher/Simd.h"
+
+namespace pattern_matcher
+{
+    struct PipelineOptions
+    {
+        // Workers matching records, 0 uses one per hardware thread
+        size_t myThreads = 0;
+
+        char myDelimiter = '\n';
+        // Whether records with nothing between two delimiters are dropped, as blank lines are in NDJSON
+        bool mySkipEmpty = true;
+
+        // Bytes of records a worker takes at a time, and how much is read from a stream at once
+        size_t myBatchSize = 1 << 16;
+        // Batches read ahead of the consumer, the reader waits once this many are in flight
+        size_t myMaxBatches = 64;
+
+        size_t myMaxDepth = 2'048;
+        size_t myMaxSteps = 4'294'967'296;
+    };
+
+    struct Record
+    {
+        // Place of the record in the input, counting only delivered records
+        size_t myIndex;
+
+        // The record without its delimiter
+        std::string_view myText;
+        std::optional<Success<const char*>> myMatch;
+
+        // Keeps the memory behind myText and myMatch alive
+        std::shared_ptr<const void> myStorage;
+    };
+
+    // Matches every record of a delimiter separated input, such as NDJSON or log lines, against one root. A reader
+    // thread finds the record boundaries with simd::ByteFinder and hands batches of records to a pool of workers
+    // sharing one CompiledGrammar. Next gives the records back in input order. At most myMaxBatches batches are read
+    // ahead of the consumer, so a slow consumer holds back the reader instead of letting the input pile up in memory.
+    template<class Key = std::string>
+    class RecordPipeline
+    {
+    public:
+        RecordPipeline(std::shared_ptr<const CompiledGrammar<Key>> aGrammar, const std::type_identity_t<Key>& aRoot,
+                       const PipelineOptions& aOptions = {})
+            : myGrammar(std::move(aGrammar)), myRoot((*myGrammar)[aRoot]), myOptions(aOptions)
+        {
+            assert(myRoot);
+
+            myOptions.myBatchSize  = std::max<size_t>(myOptions.myBatchSize, 1);
+            myOptions.myMaxBatches = std::max<size_t>(myOptions.myMaxBatches, 1);
+        }
+
+        RecordPipeline(const RecordPipeline&)            = delete;
+        RecordPipeline& operator=(const RecordPipeline&) = delete;
+
+        ~RecordPipeline()
+        {
+            {
+                std::lock_guard lock(myMutex);
+                myStopping = true;
+            }
+
+            myChanged.notify_all();
+        }
+
+        // Starts splitting and matching aFile, the records point straight into the mapping
+        void Start(std::shared_ptr<const MappedFile> aFile)
+        {
+            StartThreads([this, file = std::move(aFile)]() { ReadMapped(file); });
+        }
+
+        // Starts reading and matching aStream, which has to outlive the pipeline or be read to the end
+        void Start(std::istream& aStream)
+        {
+            StartThreads([this, &aStream]() { ReadStream(aStream); });
+        }
+
+        // The next record in input order, waits for it to be matched. Empty once every record has been given out.
+        // Rethrows what a reader or worker threw.
+        std::optional<Record> Next()
+        {
+            while (!myCurrent || myAt == myCurrent->myTexts.size())
+            {
+                std::unique_lock lock(myMutex);
+
+                if (myCurrent)
+                {
+                    myInFlight.pop_front();
+                    myCurrent = nullptr;
+                    myChanged.notify_all();
+                }
+
+                myChanged.wait(lock, [this]() {
+                    return myError || (!myInFlight.empty() && myInFlight.front()->myDone)
+                        || (myInFlight.empty() && myReadDone);
+                });
+
+                if (myError)
+                    std::rethrow_exception(myError);
+
+                if (myInFlight.empty())
+                    return {};
+
+                myCurrent = myInFlight.front();
+                myAt      = 0;
+            }
+
+            size_t at = myAt++;
+            return Record{myCurrent->myFirst + at, std::string_view(myCurrent->myTexts[at].begin(),
+                                                                    myCurrent->myTexts[at].end()),
+                          std::move(myCurrent->myMatches[at]), myCurrent->myStorage};
+        }
+
+    private:
+        using Text = std::ranges::subrange<const char*>;
+
+        struct Batch
+        {
+            size_t myFirst;
+            std::shared_ptr<const void> myStorage;
+            std::vector<Text> myTexts;
+            std::vector<std::optional<Success<const char*>>> myMatches;
+            bool myDone = false;
+        };
+
+        template<class Read>
+        void StartThreads(Read aRead)
+        {
+            assert(myThreads.empty());
+
+            size_t workers = myOptions.myThreads ? myOptions.myThreads
+                                                 : std::max(std::thread::hardware_concurrency(), 1u);
+
+            myThreads.reserve(workers + 1);
+            for (size_t i = 0; i < workers; i++) myThreads.emplace_back([this]() { Work(); });
+
+            myThreads.emplace_back([this, aRead]() {
+                try
+                {
+                    aRead();
+                }
+                catch (...)
+                {
+                    Fail(std::current_exception());
+                }
+
+                {
+                    std::lock_guard lock(myMutex);
+                    myReadDone = true;
+                }
+                myChanged.notify_all();
+            });
+        }
+
+        void ReadMapped(const std::shared_ptr<const MappedFile>& aFile)
+        {
+            const char* at  = aFile->begin();
+            const char* end = aFile->end();
+
+            while (at != end)
+            {
+                // Cut after the first delimiter past the batch size
+                const char* cut = at + std::min(myOptions.myBatchSize, static_cast<size_t>(end - at));
+                cut             = cut == end ? end : Find(cut, end);
+                if (cut != end)
+                    cut++;
+
+                if (!Push(at, cut, aFile))
+                    return;
+
+                at = cut;
+            }
+        }
+
+        void ReadStream(std::istream& aStream)
+        {
+            std::string carry;
+
+            while (true)
+            {
+                std::shared_ptr<std::string> block = std::make_shared<std::string>(std::move(carry));
+                carry.clear();
+
+                size_t kept = block->size();
+                block->resize(kept + myOptions.myBatchSize);
+                aStream.read(block->data() + kept, static_cast<std::streamsize>(myOptions.myBatchSize));
+                block->resize(kept + static_cast<size_t>(aStream.gcount()));
+
+                bool last = !aStream;
+
+                // The part after the last delimiter is carried over to the next block, a record longer than a block
+                // keeps growing until its delimiter shows up
+                if (!last)
+                {
+                    size_t cut = block->rfind(myOptions.myDelimiter);
+                    if (cut == std::string::npos)
+                    {
+                        carry = std::move(*block);
+                        continue;
+                    }
+
+                    carry.assign(*block, cut + 1);
+                    block->resize(cut + 1);
+                }
+
+                if (!block->empty() && !Push(block->data(), block->data() + block->size(), block))
+                    return;
+
+                if (last)
+                    return;
+            }
+        }
+
+        const char* Find(const char* aBegin, const char* aEnd) const
+        {
+            return reinterpret_cast<const char*>(myFinder(reinterpret_cast<const unsigned char*>(aBegin),
+                                                          reinterpret_cast<const unsigned char*>(aEnd)));
+        }
+
+        // Splits [aBegin, aEnd) into records and queues them, false when the pipeline is stopping
+        bool Push(const char* aBegin, const char* aEnd, std::shared_ptr<const void> aStorage)
+        {
+            std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+            batch->myStorage             = std::move(aStorage);
+
+            for (const char* at = aBegin; at != aEnd;)
+            {
+                const char* end = Find(at, aEnd);
+
+                if (end != at || !myOptions.mySkipEmpty)
+                    batch->myTexts.push_back(Text(at, end));
+
+                at = end == aEnd ? aEnd : end + 1;
+            }
+
+            batch->myMatches.resize(batch->myTexts.size());
+
+            std::unique_lock lock(myMutex);
+
+            myChanged.wait(lock, [this]() { return myStopping || myInFlight.size() < myOptions.myMaxBatches; });
+            if (myStopping)
+                return false;
+
+            batch->myFirst = myRecords;
+            myRecords += batch->myTexts.size();
+
+            myInFlight.push_back(batch);
+            myPending.push_back(batch);
+            myChanged.notify_all();
+
+            return true;
+        }
+
+        void Work()
+        {
+            BatchOptions options;
+            options.myThreads  = 1;
+            options.myMaxDepth = myOptions.myMaxDepth;
+            options.myMaxSteps = myOptions.myMaxSteps;
+
+            while (true)
+            {
+                std::shared_ptr<Batch> batch;
+                {
+                    std::unique_lock lock(myMutex);
+                    myChanged.wait(lock, [this]() { return myStopping || !myPending.empty() || myReadDone; });
+
+                    if (myStopping || myPending.empty())
+                        return;
+
+                    batch = std::move(myPending.front());
+                    myPending.pop_front();
+                }
+
+                try
+                {
+                    // One worker per batch, so the batch is matched on this thread reusing one context stack
+                    batch->myMatches = myGrammar->MatchMany(myRoot, batch->myTexts, options);
+                }
+                catch (...)
+                {
+                    Fail(std::current_exception());
+                    return;
+                }
+
+                {
+                    std::lock_guard lock(myMutex);
+                    batch->myDone = true;
+                }
+                myChanged.notify_all();
+            }
+        }
+
+        void Fail(std::exception_ptr aError)
+        {
+            {
+                std::lock_guard lock(myMutex);
+                if (!myError)
+                    myError = aError;
+                myStopping = true;
+            }
+            myChanged.notify_all();
+        }
+
+        std::shared_ptr<const CompiledGrammar<Key>> myGrammar;
+        const Fragment* myRoot;
+        PipelineOptions myOptions;
+        simd::ByteFinder myFinder = simd::ByteFinder(CharClass::Of(std::string_view(&myOptions.myDelimiter, 1)));
+
+        std::mutex myMutex;
+        std::condition_variable myChanged;
+        bool myStopping = false;
+        bool myReadDone = false;
+        std::exception_ptr myError;
+
+        // Batches in input order until the consumer is done with them, and the ones no worker has taken yet
+        std::deque<std::shared_ptr<Batch>> myInFlight;
+        std::deque<std::shared_ptr<Batch>> myPending;
+        size_t myRecords = 0;
+
+        // Only touched by the consumer
+        std::shared_ptr<Batch> myCurrent;
+        size_t myAt = 0;
+
+        // Last so they are joined before anything they use is destroyed
+        std::vector<std::jthread> myThreads;
+    };
+}  // namespace pattern_matcher
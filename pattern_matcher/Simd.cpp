@@ -0,0 +1,176 @@
+#include "pattern_matcher/Simd.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PATTERN_MATCHER_SIMD_DISPATCH 1
+#include <immintrin.h>
+#else
+#define PATTERN_MATCHER_SIMD_DISPATCH 0
+#endif
+
+namespace pattern_matcher::simd
+{
+    namespace
+    {
+        size_t SpanScalar(const CharClass& aClass, const unsigned char* aBegin, const unsigned char* aEnd)
+        {
+            const unsigned char* at = aBegin;
+
+            while (at != aEnd && aClass.Contains(*at)) ++at;
+
+            return static_cast<size_t>(at - aBegin);
+        }
+
+#if PATTERN_MATCHER_SIMD_DISPATCH
+
+        // Classifies 16 bytes at a time: the low nibble of each byte selects a row from the nibble tables, the high
+        // nibble selects the bit within that row
+        __attribute__((target("ssse3"))) size_t SpanSsse3(const CharClass& aClass, const unsigned char* aBegin,
+                                                          const unsigned char* aEnd)
+        {
+            const __m128i lowRows  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aClass.LowRows().data()));
+            const __m128i highRows = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aClass.HighRows().data()));
+            const __m128i bits     = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+            const __m128i nibble   = _mm_set1_epi8(0x0F);
+            const __m128i seven    = _mm_set1_epi8(7);
+
+            const unsigned char* at = aBegin;
+
+            for (; aEnd - at >= 16; at += 16)
+            {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(at));
+                __m128i low   = _mm_and_si128(bytes, nibble);
+                __m128i high  = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+
+                __m128i upper = _mm_cmpgt_epi8(high, seven);
+                __m128i row   = _mm_or_si128(_mm_and_si128(upper, _mm_shuffle_epi8(highRows, low)),
+                                             _mm_andnot_si128(upper, _mm_shuffle_epi8(lowRows, low)));
+                __m128i bit   = _mm_shuffle_epi8(bits, high);
+
+                unsigned members = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), bit)));
+
+                if (members != 0xFFFF)
+                    return static_cast<size_t>(at - aBegin) + std::countr_one(members);
+            }
+
+            return static_cast<size_t>(at - aBegin) + SpanScalar(aClass, at, aEnd);
+        }
+
+        __attribute__((target("avx2"))) size_t SpanAvx2(const CharClass& aClass, const unsigned char* aBegin,
+                                                        const unsigned char* aEnd)
+        {
+            const __m256i lowRows = _mm256_broadcastsi128_si256(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(aClass.LowRows().data())));
+            const __m256i highRows = _mm256_broadcastsi128_si256(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(aClass.HighRows().data())));
+            const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4,
+                                                  8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+            const __m256i nibble = _mm256_set1_epi8(0x0F);
+            const __m256i seven  = _mm256_set1_epi8(7);
+
+            const unsigned char* at = aBegin;
+
+            for (; aEnd - at >= 32; at += 32)
+            {
+                __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(at));
+                __m256i low   = _mm256_and_si256(bytes, nibble);
+                __m256i high  = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble);
+
+                __m256i upper = _mm256_cmpgt_epi8(high, seven);
+                __m256i row   = _mm256_blendv_epi8(_mm256_shuffle_epi8(lowRows, low),
+                                                   _mm256_shuffle_epi8(highRows, low), upper);
+                __m256i bit   = _mm256_shuffle_epi8(bits, high);
+
+                std::uint32_t members = static_cast<std::uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit)));
+
+                if (members != 0xFFFFFFFF)
+                    return static_cast<size_t>(at - aBegin) + std::countr_one(members);
+            }
+
+            return static_cast<size_t>(at - aBegin) + SpanSsse3(aClass, at, aEnd);
+        }
+
+#endif
+    }  // namespace
+
+    bool Supports(Kernel aKernel)
+    {
+        switch (aKernel)
+        {
+            case Kernel::Scalar:
+                return true;
+#if PATTERN_MATCHER_SIMD_DISPATCH
+            case Kernel::Ssse3:
+                return __builtin_cpu_supports("ssse3");
+            case Kernel::Avx2:
+                return __builtin_cpu_supports("avx2");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    Kernel Best()
+    {
+        static const Kernel best = Supports(Kernel::Avx2)    ? Kernel::Avx2
+                                 : Supports(Kernel::Ssse3) ? Kernel::Ssse3
+                                                           : Kernel::Scalar;
+        return best;
+    }
+
+    size_t SpanOf(const CharClass& aClass, const unsigned char* aBegin, const unsigned char* aEnd)
+    {
+        // Most runs are short, a miss on the first byte skips the kernel entirely
+        if (aBegin == aEnd || !aClass.Contains(*aBegin))
+            return 0;
+
+        return SpanOf(aClass, aBegin, aEnd, Best());
+    }
+
+    size_t SpanOf(const CharClass& aClass, const unsigned char* aBegin, const unsigned char* aEnd, Kernel aKernel)
+    {
+        switch (aKernel)
+        {
+#if PATTERN_MATCHER_SIMD_DISPATCH
+            case Kernel::Ssse3:
+                return SpanSsse3(aClass, aBegin, aEnd);
+            case Kernel::Avx2:
+                return SpanAvx2(aClass, aBegin, aEnd);
+#endif
+            default:
+                return SpanScalar(aClass, aBegin, aEnd);
+        }
+    }
+
+    ByteFinder::ByteFinder(const CharClass& aClass) : mySkip(aClass), myCount(aClass.Count())
+    {
+        mySkip.Invert();
+
+        if (myCount == 1)
+            for (size_t i = 0; i < CharClass::Size; i++)
+                if (aClass.Contains(static_cast<unsigned char>(i)))
+                    myByte = static_cast<unsigned char>(i);
+    }
+
+    const unsigned char* ByteFinder::operator()(const unsigned char* aBegin, const unsigned char* aEnd) const
+    {
+        if (aBegin == aEnd)
+            return aEnd;
+
+        switch (myCount)
+        {
+            case 0:
+                return aEnd;
+            case 1: {
+                const void* at = std::memchr(aBegin, myByte, static_cast<size_t>(aEnd - aBegin));
+                return at ? static_cast<const unsigned char*>(at) : aEnd;
+            }
+            default:
+                return aBegin + SpanOf(mySkip, aBegin, aEnd);
+        }
+    }
+}  // namespace pattern_matcher::simd
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#include "pattern_matcher/CharClass.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace pattern_matcher::simd
+{
+    // Compares aSize bytes, 16 at a time when SSE2 is available. Short strings go through memcmp which compilers
+    // inline for small sizes.
+    inline bool Equal(const unsigned char* aLeft, const unsigned char* aRight, size_t aSize)
+    {
+#if defined(__SSE2__)
+        if (aSize >= 16)
+        {
+            size_t at = 0;
+            for (; at + 16 <= aSize; at += 16)
+            {
+                __m128i left  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aLeft + at));
+                __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aRight + at));
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(left, right)) != 0xFFFF)
+                    return false;
+            }
+
+            if (at == aSize)
+                return true;
+
+            // Overlapping compare of the last 16 bytes
+            __m128i left  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aLeft + aSize - 16));
+            __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aRight + aSize - 16));
+
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(left, right)) == 0xFFFF;
+        }
+#endif
+
+        return std::memcmp(aLeft, aRight, aSize) == 0;
+    }
+
+    enum class Kernel
+    {
+        Scalar,
+        Ssse3,
+        Avx2
+    };
+
+    // Whether aKernel can run on this machine, checked at runtime
+    bool Supports(Kernel aKernel);
+
+    // The fastest supported kernel
+    Kernel Best();
+
+    // Length of the run of bytes from aBegin that are members of aClass, stopping at aEnd
+    size_t SpanOf(const CharClass& aClass, const unsigned char* aBegin, const unsigned char* aEnd);
+    size_t SpanOf(const CharClass& aClass, const unsigned char* aBegin, const unsigned char* aEnd, Kernel aKernel);
+
+    // Finds the next byte that is a member of a set. A set of a single byte goes through memchr, larger sets skip the
+    // run of non-members with SpanOf.
+    class ByteFinder
+    {
+    public:
+        ByteFinder(const CharClass& aClass);
+
+        // The first member from aBegin, aEnd when there is none
+        const unsigned char* operator()(const unsigned char* aBegin, const unsigned char* aEnd) const;
+
+    private:
+        CharClass mySkip;
+        size_t myCount;
+        unsigned char myByte = 0;
+    };
+}  // namespace pattern_matcher::simd
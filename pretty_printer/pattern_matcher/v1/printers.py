@@ -104,18 +104,30 @@ def NameOf(fragment):
     return str(fragment)
 
 
-def ExtractSubFragments(arr):
+def SubFragments(fragment):
     out = []
 
+    # Packed fragments hold their children as indices into the pool
+    pool = fragment["myPool"]
+    if pool != 0:
+        indices = fragment["myChildIndices"]
+        for i in range(int(fragment["myChildCount"])):
+            out.append(pool + int(indices[i]))
+        return out
+
+    arr = fragment["mySubFragments"]
     start = arr["_M_impl"]["_M_start"]
     end = arr["_M_impl"]["_M_finish"]
     length = end - start
 
     for i in range(length):
-        out.append(NameOf(start[i]))
+        out.append(start[i])
 
     return out
 
+def ExtractSubFragments(fragment):
+    return [NameOf(sub) for sub in SubFragments(fragment)]
+
 def AddToNameLookup(m):
     global NameLookup
     
@@ -168,13 +180,13 @@ class FragmentPrinter:
                 return Char(self.val["myLiteral"].bytes)
 
             case 'pattern_matcher::Fragment::Type::Sequence':
-                return " ".join(ExtractSubFragments(self.val["mySubFragments"]))
+                return " ".join(ExtractSubFragments(self.val))
 
             case 'pattern_matcher::Fragment::Type::Alternative':
-                return "(" + "|".join(ExtractSubFragments(self.val["mySubFragments"])) + ")"
+                return "(" + "|".join(ExtractSubFragments(self.val)) + ")"
 
             case 'pattern_matcher::Fragment::Type::Repeat':
-                return NameOf(self.val["mySubFragments"]["_M_impl"]["_M_start"].dereference()) + " " + str(self.val["myCount"])[1:-1]
+                return NameOf(SubFragments(self.val)[0]) + " " + str(self.val["myCount"])[1:-1]
 
             case 'pattern_matcher::Fragment::Type::None':
                 return "<Uninitialized>"